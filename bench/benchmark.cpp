@@ -0,0 +1,91 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "benchmark.h"
+#include <albert/logging.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+ALBERT_LOGGING_CATEGORY("spotify")
+using namespace std;
+
+static atomic<quint64> allocationCount = 0;
+
+#ifdef __GLIBC__
+// Qt containers allocate by malloc directly, so it is counted rather than operator new, which calls it anyway.
+extern "C"
+{
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+
+void* malloc(const size_t size) noexcept
+{
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(const size_t count, const size_t size) noexcept
+{
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, const size_t size) noexcept
+{
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+}
+#endif
+
+
+quint64 Benchmark::allocations() { return allocationCount.load(memory_order_relaxed); }
+
+void Benchmark::print(const QString& name, const Result& result)
+{
+    cout << QString("  %1 %2 ns/op %3 allocs/op")
+                .arg(name, -40)
+                .arg(result.nsecs, 12, 'f', 1)
+                .arg(result.allocations, 9, 'f', 1)
+                .toStdString()
+         << endl;
+}
+
+
+void Samples::add(const qint64 nsecs)
+{
+    samples.append(nsecs);
+    sorted = false;
+}
+
+qsizetype Samples::size() const { return samples.size(); }
+
+qint64 Samples::percentile(const double p) const
+{
+    if (samples.isEmpty())
+        return 0;
+
+    if (!sorted)
+    {
+        ranges::sort(samples);
+        sorted = true;
+    }
+
+    // Nearest rank, so p99 of a hundred samples is the largest but one.
+    const auto rank = static_cast<qsizetype>(ceil(p * static_cast<double>(samples.size())));
+    return samples.at(clamp<qsizetype>(rank - 1, 0, samples.size() - 1));
+}
+
+QString Samples::summary(const QString& name) const
+{
+    const auto msecs = [](const qint64 nsecs) { return QString::number(static_cast<double>(nsecs) / 1e6, 'f', 2); };
+    const auto mean = samples.isEmpty() ? 0 : accumulate(samples.cbegin(), samples.cend(), 0LL) / samples.size();
+
+    return QString("%1 %2× mean %3 ms, p50 %4 ms, p95 %5 ms, p99 %6 ms")
+        .arg(name, -24)
+        .arg(samples.size(), 5)
+        .arg(msecs(mean), msecs(percentile(0.5)), msecs(percentile(0.95)), msecs(percentile(0.99)));
+}
@@ -0,0 +1,110 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+
+/**
+ * Runs microbenchmarks and reports their time and heap allocations per call.
+ * Allocations are counted by interposing malloc, which is supported on glibc only,
+ * elsewhere they are reported as zero.
+ */
+class Benchmark
+{
+public:
+    struct Result
+    {
+        double nsecs = 0;        // Time per call in nanoseconds
+        double allocations = 0;  // Heap allocations per call
+    };
+
+    /**
+     * Returns number of heap allocations of the process so far.
+     */
+    static quint64 allocations();
+
+    /**
+     * Call a function repeatedly until enough time passed and print its cost per call.
+     * @param name Name of the measured operation.
+     * @param function The function to measure, its result is kept from being optimized out.
+     * @return Time and allocations per call.
+     */
+    template<typename Function>
+    static Result run(const QString& name, Function&& function)
+    {
+        // The first call warms up caches and lazy initializations.
+        keep(function());
+
+        for (qint64 iterations = 1;; iterations *= 2)
+        {
+            const auto allocationsBefore = allocations();
+            QElapsedTimer timer;
+            timer.start();
+
+            for (qint64 i = 0; i < iterations; ++i)
+                keep(function());
+
+            if (const auto elapsed = timer.nsecsElapsed(); elapsed >= MIN_DURATION || iterations >= MAX_ITERATIONS)
+            {
+                const Result result{
+                    .nsecs = static_cast<double>(elapsed) / static_cast<double>(iterations),
+                    .allocations = static_cast<double>(allocations() - allocationsBefore) / static_cast<double>(iterations)
+                };
+                print(name, result);
+                return result;
+            }
+        }
+    }
+
+    /**
+     * Print a measured result.
+     */
+    static void print(const QString& name, const Result& result);
+
+private:
+    static constexpr qint64 MIN_DURATION = 200000000;  // Nanoseconds a measurement runs at least
+    static constexpr qint64 MAX_ITERATIONS = 1 << 24;
+
+    /**
+     * Keep a value from being optimized out without copying it.
+     */
+    template<typename T>
+    static void keep(const T& value) { asm volatile("" : : "r"(&value) : "memory"); }
+};
+
+
+/**
+ * Durations measured by a benchmark, summarized by their percentiles.
+ */
+class Samples
+{
+public:
+    /**
+     * Add a measured duration.
+     * @param nsecs The duration in nanoseconds.
+     */
+    void add(qint64 nsecs);
+
+    /**
+     * Returns number of samples.
+     */
+    qsizetype size() const;
+
+    /**
+     * Returns the smallest sample not exceeded by the given share of samples, in nanoseconds.
+     * @param p The share between 0 and 1, e.g. 0.95 for the 95th percentile.
+     */
+    qint64 percentile(double p) const;
+
+    /**
+     * Returns one line with the count, mean and p50/p95/p99 of the samples in milliseconds.
+     * @param name Name of the measured workload.
+     */
+    QString summary(const QString& name) const;
+
+private:
+    mutable QVector<qint64> samples;
+    mutable bool sorted = true;
+};
@@ -0,0 +1,235 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "fixtures.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+using namespace std;
+
+inline QString WEB_URL = "https://open.spotify.com";
+inline QString API_URL = "https://api.spotify.com/v1";
+inline int ARTIST_POOL = 40;
+inline int ALBUMS_PER_ARTIST = 6;
+inline int MARKETS = 60;  // Real responses list up to 185 markets per track and album
+inline QStringList WORDS = {
+    "love", "night", "heart", "blue", "fire", "dream", "light", "river", "home", "paper", "golden",
+    "silent", "electric", "summer", "shadow", "wild", "city", "young", "stone", "ocean", "creep",
+    "karma", "police", "paranoid", "android", "street", "spirit", "lucky", "airbag", "echoes"
+};
+inline QStringList DEVICE_TYPES = {"Computer", "Smartphone", "Speaker", "TV", "CastAudio"};
+
+
+/**
+ * Returns a base62 ID of a Spotify object, derived from the given numbers.
+ */
+static QString spotifyId(const char* kind, const quint64 number)
+{
+    static constexpr char digits[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    quint64 value = qHash(QByteArray(kind)) ^ (number * 0x9E3779B97F4A7C15ULL);
+
+    QByteArray id;
+    for (int i = 0; i < 22; ++i)
+    {
+        id += digits[value % 62];
+        value = value / 62 + (value % 62 + 1) * 0x2545F4914F6CDD1DULL;
+    }
+    return QString::fromLatin1(id);
+}
+
+/**
+ * Returns a title of a few words drawn from the pool.
+ */
+static QString title(QRandomGenerator& random, const int minWords, const int maxWords)
+{
+    QStringList words;
+    for (int i = random.bounded(minWords, maxWords + 1); i > 0; --i)
+    {
+        auto word = WORDS.at(random.bounded(static_cast<int>(WORDS.size())));
+        word[0] = word[0].toUpper();
+        words.append(word);
+    }
+    return words.join(' ');
+}
+
+static QJsonArray markets()
+{
+    QJsonArray array;
+    for (int i = 0; i < MARKETS; ++i)
+        array.append(QString("%1%2").arg(QChar('A' + i / 26)).arg(QChar('A' + i % 26)));
+    return array;
+}
+
+static QJsonObject links(const QString& type, const QString& id)
+{
+    return {
+        {"external_urls", QJsonObject{{"spotify", QString("%1/%2/%3").arg(WEB_URL, type, id)}}},
+        {"href", QString("%1/%2s/%3").arg(API_URL, type, id)},
+        {"id", id},
+        {"type", type},
+        {"uri", QString("spotify:%1:%2").arg(type, id)}
+    };
+}
+
+static QJsonArray images(const QString& imageBaseUrl, const QString& id)
+{
+    QJsonArray array;
+    for (const auto size : {640, 300, 64})
+        array.append(QJsonObject{{"height", size}, {"url", QString("%1/image/%2/%3").arg(imageBaseUrl, id).arg(size)},
+                                 {"width", size}});
+    return array;
+}
+
+static QJsonObject artist(const int index)
+{
+    QRandomGenerator random(static_cast<quint32>(index));
+
+    auto object = links("artist", spotifyId("artist", index));
+    object["name"] = title(random, 1, 3);
+    return object;
+}
+
+static QJsonObject album(const int artistIndex, const int albumIndex, const QString& imageBaseUrl)
+{
+    QRandomGenerator random(static_cast<quint32>(artistIndex * ALBUMS_PER_ARTIST + albumIndex + 1000));
+    const auto id = spotifyId("album", artistIndex * ALBUMS_PER_ARTIST + albumIndex);
+
+    auto object = links("album", id);
+    object["album_type"] = "album";
+    object["artists"] = QJsonArray{artist(artistIndex)};
+    object["available_markets"] = markets();
+    object["images"] = images(imageBaseUrl, id);
+    object["name"] = title(random, 1, 4);
+    object["release_date"] = QString("%1-05-21").arg(1970 + random.bounded(55));
+    object["release_date_precision"] = "day";
+    object["total_tracks"] = random.bounded(8, 20);
+    return object;
+}
+
+static QJsonObject track(QRandomGenerator& random, const quint64 number, const QString& imageBaseUrl)
+{
+    const auto artistIndex = random.bounded(ARTIST_POOL);
+    const auto id = spotifyId("track", number);
+
+    QJsonArray artists = {artist(artistIndex)};
+    if (random.bounded(4) == 0)
+        artists.append(artist(random.bounded(ARTIST_POOL)));
+
+    auto object = links("track", id);
+    object["album"] = album(artistIndex, random.bounded(ALBUMS_PER_ARTIST), imageBaseUrl);
+    object["artists"] = artists;
+    object["available_markets"] = markets();
+    object["disc_number"] = 1;
+    object["duration_ms"] = random.bounded(120000, 420000);
+    object["explicit"] = random.bounded(5) == 0;
+    object["external_ids"] = QJsonObject{{"isrc", QString("USRC1%1").arg(number % 10000000, 7, 10, QChar('0'))}};
+    object["is_local"] = false;
+    object["name"] = title(random, 1, 5);
+    object["popularity"] = random.bounded(100);
+    object["preview_url"] = QJsonValue::Null;
+    object["track_number"] = random.bounded(1, 13);
+    return object;
+}
+
+static QJsonObject playlist(QRandomGenerator& random, const quint64 number, const QString& imageBaseUrl)
+{
+    const auto id = spotifyId("playlist", number);
+
+    auto object = links("playlist", id);
+    object["collaborative"] = false;
+    object["description"] = "The best of " + title(random, 1, 3);
+    object["images"] = QJsonArray{QJsonObject{{"height", QJsonValue::Null},
+                                              {"url", QString("%1/image/%2/640").arg(imageBaseUrl, id)},
+                                              {"width", QJsonValue::Null}}};
+    object["name"] = title(random, 2, 4);
+    object["owner"] = QJsonObject{{"display_name", title(random, 1, 2)}, {"id", spotifyId("user", number)}};
+    object["public"] = true;
+    object["snapshot_id"] = spotifyId("snapshot", number);
+    object["tracks"] = QJsonObject{{"href", QString("%1/playlists/%2/tracks").arg(API_URL, id)},
+                                   {"total", random.bounded(10, 300)}};
+    return object;
+}
+
+QByteArray Fixtures::searchResponse(const QString& query, const QStringList& types, const int limit,
+                                    const int offset, const QString& imageBaseUrl)
+{
+    QJsonObject response;
+
+    for (const auto& type : types)
+    {
+        QRandomGenerator random(static_cast<quint32>(qHash(query + type) + static_cast<size_t>(offset)));
+        QJsonArray items;
+
+        for (int i = 0; i < limit; ++i)
+        {
+            const auto number = qHash(query) + static_cast<size_t>(offset + i);
+
+            if (type == "track")
+                items.append(track(random, number, imageBaseUrl));
+            else if (type == "album")
+                items.append(album(random.bounded(ARTIST_POOL), random.bounded(ALBUMS_PER_ARTIST), imageBaseUrl));
+            else if (type == "artist")
+            {
+                const auto index = random.bounded(ARTIST_POOL);
+                auto object = artist(index);
+                object["followers"] = QJsonObject{{"href", QJsonValue::Null}, {"total", random.bounded(1000000)}};
+                object["genres"] = QJsonArray{"rock", "alternative rock"};
+                object["images"] = images(imageBaseUrl, object["id"].toString());
+                object["popularity"] = random.bounded(100);
+                items.append(object);
+            }
+            // The Web API answers some playlists with null.
+            else if (type == "playlist")
+                items.append(i % 7 == 6 ? QJsonValue(QJsonValue::Null) : playlist(random, number, imageBaseUrl));
+        }
+
+        const auto href = QString("%1/search?query=%2&type=%3&offset=%4&limit=%5")
+                              .arg(API_URL, query, type).arg(offset).arg(limit);
+        response[type + u's'] = QJsonObject{
+            {"href", href},
+            {"items", items},
+            {"limit", limit},
+            {"next", QString(href).replace(QString("offset=%1").arg(offset), QString("offset=%1").arg(offset + limit))},
+            {"offset", offset},
+            {"previous", QJsonValue::Null},
+            {"total", 1000}
+        };
+    }
+
+    return QJsonDocument(response).toJson(QJsonDocument::Compact);
+}
+
+QByteArray Fixtures::devicesResponse(const int count)
+{
+    QJsonArray devices;
+
+    for (int i = 0; i < count; ++i)
+        devices.append(QJsonObject{
+            {"id", spotifyId("device", i)},
+            {"is_active", i == 0},
+            {"is_private_session", false},
+            {"is_restricted", false},
+            {"name", QString("Device %1").arg(i + 1)},
+            {"supports_volume", true},
+            {"type", DEVICE_TYPES.at(i % DEVICE_TYPES.size())},
+            {"volume_percent", 50}
+        });
+
+    return QJsonDocument(QJsonObject{{"devices", devices}}).toJson(QJsonDocument::Compact);
+}
+
+QByteArray Fixtures::tokenResponse(const int expiresIn)
+{
+    return QJsonDocument(QJsonObject{
+        {"access_token", "BQ" + spotifyId("token", QRandomGenerator::global()->generate64()).repeated(6)},
+        {"token_type", "Bearer"},
+        {"expires_in", expiresIn},
+        {"scope", "user-modify-playback-state user-read-playback-state"}
+    }).toJson(QJsonDocument::Compact);
+}
+
+QByteArray Fixtures::image(const int size)
+{
+    const auto header = QByteArray::fromHex("ffd8ffe000104a46494600010100000100010000");
+    return header + QByteArray(max<qsizetype>(size - header.size(), 0), '\0');
+}
@@ -0,0 +1,47 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+
+/**
+ * Synthetic Web API responses shaped like the real ones.
+ *
+ * The payloads carry all the fields Spotify sends, including the ones the plugin skips,
+ * e.g. available markets and external URLs, so parsing them costs about as much as parsing
+ * real responses. Names are drawn from small pools, so artists and albums repeat across
+ * results as they do in real searches. The same arguments always give the same payload.
+ */
+class Fixtures
+{
+public:
+    /**
+     * Returns a search response.
+     * @param query The search query, it seeds the generated names.
+     * @param types Result types to include, e.g. track, album, artist and playlist.
+     * @param limit Number of results of each type.
+     * @param offset Index of the first result of each type.
+     * @param imageBaseUrl Base URL of the cover images, e.g. the one of the mock server.
+     */
+    static QByteArray searchResponse(const QString& query, const QStringList& types, int limit, int offset = 0,
+                                     const QString& imageBaseUrl = "https://i.scdn.co");
+
+    /**
+     * Returns a device list response.
+     * @param count Number of devices, the first one is active.
+     */
+    static QByteArray devicesResponse(int count);
+
+    /**
+     * Returns an access token response.
+     * @param expiresIn Seconds until the token expires.
+     */
+    static QByteArray tokenResponse(int expiresIn = 3600);
+
+    /**
+     * Returns a small image, a valid JPEG header followed by padding of the given size.
+     */
+    static QByteArray image(int size = 4096);
+};
@@ -0,0 +1,95 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "benchmark.h"
+#include "fuzzyMatcher.h"
+#include <QRandomGenerator>
+#include <iostream>
+using namespace std;
+
+inline QList<int> KEY_COUNTS = {10000, 50000, 100000};
+inline QStringList SYLLABLES = {
+    "ra", "di", "o", "he", "ad", "cre", "ep", "mo", "on", "li", "ght", "ka", "rma", "po", "lis",
+    "blu", "san", "ta", "vel", "ri", "ver", "son", "ga", "tor", "nel", "ba", "quo", "fen", "dy", "wic"
+};
+inline QStringList KNOWN_KEYS = {
+    "creep radiohead pablo honey",
+    "karma police radiohead ok computer",
+    "paranoid android radiohead ok computer",
+    "blue monday new order power, corruption & lies"
+};
+inline QStringList QUERIES = {
+    "radiohead creep",  // Exact words
+    "radiohed crep",    // Misspelled words
+    "karma pol",        // Word being typed
+    "ok",               // Short word matching many keys
+    "xylophonic zebra"  // Nothing matches
+};
+inline qsizetype RESULT_LIMIT = 20;
+
+
+/**
+ * Returns a made up word of a few syllables, so the keys have a vocabulary as large as a real library.
+ */
+static QString word(QRandomGenerator& random)
+{
+    QString word;
+    for (int i = random.bounded(2, 5); i > 0; --i)
+        word += SYLLABLES.at(random.bounded(static_cast<int>(SYLLABLES.size())));
+    return word;
+}
+
+/**
+ * Returns lowercased keys of tracks made of the name, the artists and the album name,
+ * like the ones of the library index. A few known tracks are spread among them.
+ */
+static QList<QByteArray> keys(const int count)
+{
+    QRandomGenerator random(42);
+    QList<QByteArray> keys;
+    keys.reserve(count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (i % (count / KNOWN_KEYS.size()) == 0)
+        {
+            keys.append(KNOWN_KEYS.at(i / (count / KNOWN_KEYS.size()) % KNOWN_KEYS.size()).toUtf8());
+            continue;
+        }
+
+        QStringList words;
+        for (int j = random.bounded(3, 9); j > 0; --j)
+            words.append(word(random));
+        keys.append(words.join(' ').toUtf8());
+    }
+
+    return keys;
+}
+
+/**
+ * Time to build the matcher and to match typical queries against keys of large libraries.
+ */
+int main()
+{
+    for (const auto count : KEY_COUNTS)
+    {
+        cout << count << " keys" << endl;
+
+        const auto keyList = keys(count);
+        FuzzyMatcher matcher;
+
+        const auto build = [&]
+        {
+            matcher.clear();
+            for (const auto& key : keyList)
+                matcher.append(string_view(key.constData(), key.size()));
+            return matcher.size();
+        };
+
+        Benchmark::run("build", build);
+
+        for (const auto& query : QUERIES)
+            Benchmark::run(QString("match \"%1\"").arg(query), [&] { return matcher.match(query, RESULT_LIMIT); });
+    }
+
+    return 0;
+}
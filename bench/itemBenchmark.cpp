@@ -0,0 +1,153 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "benchmark.h"
+#include "fixtures.h"
+#include "resultItems.h"
+#include "searchParser.h"
+#include "spotifyApiClient.h"
+#include <albert/standarditem.h>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+using namespace albert;
+using namespace std;
+
+inline QStringList TRACK_TYPES = {"track"};
+inline QList<int> TRACK_COUNTS = {5, 50, 500};
+inline QList<int> DEVICE_COUNTS = {1, 5, 20};
+
+
+static void play(const Track&, const QString&) {}
+
+/**
+ * Build items of a result set like the query handler does, every item points into the shared set.
+ */
+static vector<shared_ptr<StandardItem>> buildItems(const ResultItems& items,
+                                                   const shared_ptr<const QVector<Track>>& tracks,
+                                                   const QVector<Device>& devices)
+{
+    vector<shared_ptr<StandardItem>> result;
+    result.reserve(tracks->size());
+
+    for (const auto& track : *tracks)
+        result.push_back(items.buildTrackItem(shared_ptr<const Track>(tracks, &track), devices,
+                                              "/covers/" + track.albumId));
+
+    return result;
+}
+
+/**
+ * Baseline of the comparison, a result item built the way ResultItems did before tracks were
+ * shared, every action holds copies of the track and of its device.
+ */
+static shared_ptr<StandardItem> buildTrackItemCopying(const Track& track, const QVector<Device>& devices,
+                                                      const QString& coverPath)
+{
+    const auto result = StandardItem::make(
+        track.id,
+        track.name,
+        QString("%1 (%2)").arg(track.albumName, track.artists),
+        nullptr,
+        {coverPath});
+
+    auto actions = vector<Action>();
+
+    actions.emplace_back("play", "Play on Spotify", [track] { play(track, {}); });
+    actions.emplace_back("queue", "Add to the Spotify queue", [track] { play(track, {}); });
+
+    for (const auto& device : devices)
+    {
+        if (device.isActive) continue;
+
+        actions.emplace_back(
+            QString("play_on_%1").arg(device.id),
+            QString("Play on %1 (%2)").arg(device.type, device.name),
+            [track, device] { play(track, device.id); }
+        );
+    }
+
+    result->setActions(actions);
+
+    return result;
+}
+
+/**
+ * Build items of a result set the way the query handler did before tracks were shared.
+ */
+static vector<shared_ptr<StandardItem>> buildItemsCopying(const QVector<Track>& tracks, const QVector<Device>& devices)
+{
+    vector<shared_ptr<StandardItem>> items;
+    items.reserve(tracks.size());
+
+    for (const auto& track : tracks)
+        items.push_back(buildTrackItemCopying(track, devices, "/covers/" + track.albumId));
+
+    return items;
+}
+
+/**
+ * Per-result costs of parsing responses and building result items, independent of the network.
+ */
+int main()
+{
+    cout << "Parsing" << endl;
+
+    for (const auto count : TRACK_COUNTS)
+    {
+        const auto body = Fixtures::searchResponse("radiohead", TRACK_TYPES, count);
+        Benchmark::run(QString("search response of %1 tracks").arg(count), [&] { return SearchParser::parse(body); });
+    }
+
+    for (const auto count : DEVICE_COUNTS)
+    {
+        const auto body = Fixtures::devicesResponse(count);
+        Benchmark::run(QString("device list of %1 devices").arg(count),
+                       [&] { return SpotifyApiClient::parseDevices(body); });
+    }
+
+    cout << "Items" << endl;
+
+    // The actions are never triggered, so they do nothing.
+    const ResultItems items({
+        .play = [](const Track&) {},
+        .playOn = [](const Track&, const QString&) {},
+        .queue = [](const Track&) {}
+    });
+
+    for (const auto trackCount : TRACK_COUNTS)
+    {
+        const auto tracks = make_shared<const QVector<Track>>(
+            SearchParser::parse(Fixtures::searchResponse("radiohead", TRACK_TYPES, trackCount)).tracks);
+
+        for (const auto deviceCount : DEVICE_COUNTS)
+        {
+            const auto devices = SpotifyApiClient::parseDevices(Fixtures::devicesResponse(deviceCount));
+            Benchmark::run(QString("%1 tracks × %2 devices").arg(trackCount).arg(deviceCount),
+                           [&] { return buildItems(items, tracks, devices); });
+        }
+    }
+
+    // Copies of tracks do not fit into the actions inline, so every action allocates a copy.
+    cout << "Copied and shared tracks" << endl;
+
+    for (const auto& [trackCount, deviceCount] : {pair(20, 5), pair(50, 20)})
+    {
+        const auto tracks = make_shared<const QVector<Track>>(
+            SearchParser::parse(Fixtures::searchResponse("radiohead", TRACK_TYPES, trackCount)).tracks);
+        const auto devices = SpotifyApiClient::parseDevices(Fixtures::devicesResponse(deviceCount));
+        const auto name = QString("%1 tracks × %2 devices").arg(trackCount).arg(deviceCount);
+
+        const auto copied = Benchmark::run("copied " + name, [&] { return buildItemsCopying(*tracks, devices); });
+        const auto shared = Benchmark::run("shared " + name, [&] { return buildItems(items, tracks, devices); });
+
+        cout << QString("  %1 allocations fewer per result set, %2 → %3")
+                    .arg(copied.allocations - shared.allocations, 0, 'f', 0)
+                    .arg(copied.allocations, 0, 'f', 0)
+                    .arg(shared.allocations, 0, 'f', 0)
+                    .toStdString()
+             << endl;
+    }
+
+    return 0;
+}
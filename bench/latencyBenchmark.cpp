@@ -0,0 +1,167 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "benchmark.h"
+#include "mockSpotifyServer.h"
+#include "remoteSearch.h"
+#include "spotifyApiClient.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QThread>
+#include <iostream>
+#include <memory>
+using namespace std;
+
+inline int RESULT_COUNT = 5;
+inline QStringList QUERIES = {
+    "radiohead creep", "daft punk", "paranoid android", "karma police",
+    "blue monday", "golden hour", "electric feel", "street spirit"
+};
+
+
+/**
+ * Run the Web API part of a query through the same code as the query handler.
+ * @param failures Incremented if the query did not find results, e.g. due to injected errors.
+ * @return Time to results in nanoseconds.
+ */
+static qint64 runQuery(SpotifyApiClient& api, const QString& query, int& failures)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if (const auto result = RemoteSearch::fetch(api, query, RESULT_COUNT, true, [] { return true; });
+        result.status != RemoteSearch::Status::Found || result.results.tracks.isEmpty())
+        ++failures;
+
+    return timer.nsecsElapsed();
+}
+
+/**
+ * Measure time to results of representative workloads and print their percentiles.
+ * @param api The client, queries are run from the calling thread.
+ * @param iterations Number of queries of each workload.
+ * @param interval Pause between queries in milliseconds, like between keystrokes.
+ */
+static void runWorkloads(SpotifyApiClient& api, const int iterations, const int interval)
+{
+    Samples cold, typing, repeated;
+    int failures = 0;
+
+    // Queries nobody searched before, each of them is sent to the server.
+    for (int i = 0; i < iterations; ++i)
+    {
+        cold.add(runQuery(api, QString("%1 %2").arg(QUERIES.at(i % QUERIES.size())).arg(i), failures));
+        QThread::msleep(interval);
+    }
+
+    // Queries typed key by key, every keystroke is a query of its own and shares its prefix
+    // with the previous ones.
+    QStringList keystrokes;
+    for (const auto& query : QUERIES)
+        for (qsizetype size = 1; size <= query.size(); ++size)
+            keystrokes.append(query.left(size));
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        typing.add(runQuery(api, keystrokes.at(i % keystrokes.size()), failures));
+        QThread::msleep(interval);
+    }
+
+    // The cold queries again, answered by the search cache.
+    for (int i = 0; i < iterations; ++i)
+        repeated.add(runQuery(api, QString("%1 %2").arg(QUERIES.at(i % QUERIES.size())).arg(i), failures));
+
+    cout << "Time to results\n"
+         << "  " << cold.summary("cold queries").toStdString() << '\n'
+         << "  " << typing.summary("typed keystrokes").toStdString() << '\n'
+         << "  " << repeated.summary("repeated queries").toStdString() << '\n'
+         << "  failed queries " << failures << endl;
+}
+
+/**
+ * Run the workloads with a client pointed at the server by the environment.
+ */
+static int runClient(const QCommandLineParser& parser)
+{
+    QTemporaryDir cacheDirectory;
+    SpotifyApiClient api("mock-client-id", "mock-client-secret", "mock-refresh-token");
+    api.metrics().setEnabled(true);
+    api.setCacheDirectory(cacheDirectory.path());
+    api.startTokenRefresh();
+
+    // The client lives on the main thread like in Albert, queries come from a thread of their own.
+    const auto iterations = parser.value("iterations").toInt();
+    const auto interval = parser.value("interval").toInt();
+    const unique_ptr<QThread> queries(QThread::create([&] { runWorkloads(api, iterations, interval); }));
+
+    QObject::connect(queries.get(), &QThread::finished, qApp, &QCoreApplication::quit);
+    queries->start();
+
+    const auto result = QCoreApplication::exec();
+    queries->wait();
+
+    cout << api.statisticsSummary().toStdString() << endl;
+    return result;
+}
+
+/**
+ * Start the mock server and run the benchmark in a child process pointed at it.
+ * The base URLs of the client are read once at startup, so they are set by the environment
+ * of the child rather than changed in this process.
+ */
+static int runServer(const QCommandLineParser& parser)
+{
+    MockSpotifyServer server(MockSpotifyServer::readOptions(parser));
+
+    if (!server.start())
+    {
+        cerr << "Failed to start the mock server." << endl;
+        return 1;
+    }
+
+    auto environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("ALBERT_SPOTIFY_API_URL", server.url());
+    environment.insert("ALBERT_SPOTIFY_ACCOUNTS_URL", server.url());
+
+    QProcess client;
+    client.setProcessEnvironment(environment);
+    client.setProcessChannelMode(QProcess::ForwardedChannels);
+    client.start(QCoreApplication::applicationFilePath(), QCoreApplication::arguments().mid(1));
+
+    if (!client.waitForFinished(-1) || client.exitStatus() != QProcess::NormalExit)
+    {
+        cerr << "The benchmark client failed." << endl;
+        return 1;
+    }
+
+    cout << "Requests received by the server" << endl;
+    const auto counts = server.requestCounts();
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it)
+        cout << "  " << it.key().toStdString() << ": " << it.value() << endl;
+
+    return client.exitCode();
+}
+
+/**
+ * End-to-end latency of queries against a local mock Web API, reported as p50/p95/p99.
+ * Runs against a server given by ALBERT_SPOTIFY_API_URL and ALBERT_SPOTIFY_ACCOUNTS_URL
+ * if they are set, e.g. a running mockServer, otherwise starts one of its own.
+ */
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("End-to-end latency of queries against a local mock Web API.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"iterations", "Number of queries of each workload.", "count", "50"},
+        {"interval", "Pause between queries in milliseconds.", "msecs", "250"}
+    });
+    MockSpotifyServer::addOptions(parser);
+    parser.process(app);
+
+    return qEnvironmentVariableIsSet("ALBERT_SPOTIFY_API_URL") ? runClient(parser) : runServer(parser);
+}
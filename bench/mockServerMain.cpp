@@ -0,0 +1,39 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "mockSpotifyServer.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <iostream>
+using namespace std;
+
+inline quint16 DEFAULT_PORT = 8899;
+
+
+/**
+ * Serve the mock Web API until interrupted, e.g. to point a running Albert at it.
+ */
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local stand-in for the Spotify Web API.");
+    parser.addHelpOption();
+    parser.addOption({"port", "Port to listen on.", "port", QString::number(DEFAULT_PORT)});
+    MockSpotifyServer::addOptions(parser);
+    parser.process(app);
+
+    MockSpotifyServer server(MockSpotifyServer::readOptions(parser));
+
+    if (!server.start(static_cast<quint16>(parser.value("port").toUInt())))
+    {
+        cerr << "Failed to listen on port " << parser.value("port").toStdString() << endl;
+        return 1;
+    }
+
+    cout << "Serving on " << server.url().toStdString() << ", point the plugin at it with:\n"
+         << "  export ALBERT_SPOTIFY_API_URL=" << server.url().toStdString() << '\n'
+         << "  export ALBERT_SPOTIFY_ACCOUNTS_URL=" << server.url().toStdString() << endl;
+
+    return QCoreApplication::exec();
+}
@@ -0,0 +1,252 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "fixtures.h"
+#include "mockSpotifyServer.h"
+#include <QCommandLineParser>
+#include <QCryptographicHash>
+#include <QRandomGenerator>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+#include <memory>
+using namespace std;
+
+inline QByteArray HEADER_END = "\r\n\r\n";
+inline QHash<int, QByteArray> REASONS = {
+    {200, "OK"}, {204, "No Content"}, {304, "Not Modified"}, {400, "Bad Request"}, {401, "Unauthorized"},
+    {404, "Not Found"}, {405, "Method Not Allowed"}, {429, "Too Many Requests"}, {500, "Internal Server Error"}
+};
+
+
+MockSpotifyServer::MockSpotifyServer(const Options& options):
+    options(options)
+{
+    thread.setObjectName("MockSpotifyServer");
+    thread.start();
+}
+
+MockSpotifyServer::~MockSpotifyServer()
+{
+    // Connections are children of the server, so they go away with it on its own thread.
+    if (server)
+        QMetaObject::invokeMethod(server, [this] { delete server; }, Qt::BlockingQueuedConnection);
+
+    thread.quit();
+    thread.wait();
+}
+
+bool MockSpotifyServer::start(const quint16 requestedPort)
+{
+    server = new QTcpServer;
+
+    if (!server->listen(QHostAddress::LocalHost, requestedPort))
+    {
+        delete server;
+        server = nullptr;
+        return false;
+    }
+
+    port = server->serverPort();
+
+    QObject::connect(server, &QTcpServer::newConnection, server, [this]
+    {
+        while (const auto socket = server->nextPendingConnection())
+        {
+            const auto buffer = make_shared<QByteArray>();
+
+            QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket, buffer]
+            {
+                buffer->append(socket->readAll());
+                serve(socket, *buffer);
+            });
+            QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        }
+    });
+
+    // Connections are accepted and served on the thread of the server, away from the client.
+    server->moveToThread(&thread);
+    return true;
+}
+
+void MockSpotifyServer::addOptions(QCommandLineParser& parser)
+{
+    const Options defaults;
+
+    parser.addOptions({
+        {"latency", "Base delay of responses in milliseconds.", "msecs", QString::number(defaults.latency)},
+        {"jitter", "Maximum random delay added to responses in milliseconds.", "msecs",
+         QString::number(defaults.jitter)},
+        {"error-rate", "Share of Web API responses failing with 500.", "share", QString::number(defaults.errorRate)},
+        {"rate-limit-rate", "Share of Web API responses failing with 429.", "share",
+         QString::number(defaults.rateLimitRate)},
+        {"retry-after", "Retry-After of rate limited responses in seconds.", "secs",
+         QString::number(defaults.retryAfter)},
+        {"devices", "Number of devices of the user.", "count", QString::number(defaults.devices)}
+    });
+}
+
+MockSpotifyServer::Options MockSpotifyServer::readOptions(const QCommandLineParser& parser)
+{
+    return {
+        .latency = parser.value("latency").toInt(),
+        .jitter = parser.value("jitter").toInt(),
+        .errorRate = parser.value("error-rate").toDouble(),
+        .rateLimitRate = parser.value("rate-limit-rate").toDouble(),
+        .retryAfter = parser.value("retry-after").toInt(),
+        .devices = parser.value("devices").toInt()
+    };
+}
+
+QString MockSpotifyServer::url() const { return QString("http://127.0.0.1:%1").arg(port); }
+
+QHash<QString, quint64> MockSpotifyServer::requestCounts() const
+{
+    QMutexLocker locker(&mutex);
+    return counts;
+}
+
+void MockSpotifyServer::serve(QTcpSocket* socket, QByteArray& buffer)
+{
+    while (true)
+    {
+        const auto headerEnd = buffer.indexOf(HEADER_END);
+        if (headerEnd < 0)
+            return;
+
+        const auto lines = buffer.left(headerEnd).split('\n');
+        const auto requestLine = lines.first().trimmed().split(' ');
+        if (requestLine.size() < 2)
+        {
+            socket->abort();
+            return;
+        }
+
+        Request request;
+        request.method = requestLine.at(0);
+
+        const auto target = QUrl(QString::fromUtf8(requestLine.at(1)));
+        request.path = target.path();
+        request.query = QUrlQuery(target);
+
+        for (qsizetype i = 1; i < lines.size(); ++i)
+            if (const auto colon = lines.at(i).indexOf(':'); colon > 0)
+                request.headers.insert(lines.at(i).left(colon).trimmed().toLower(),
+                                       lines.at(i).mid(colon + 1).trimmed());
+
+        // Bodies are not needed by any endpoint, they are just skipped.
+        const auto bodySize = request.headers.value("content-length").toLongLong();
+        if (buffer.size() < headerEnd + HEADER_END.size() + bodySize)
+            return;
+
+        buffer.remove(0, headerEnd + HEADER_END.size() + bodySize);
+
+        const auto keepAlive = request.headers.value("connection").toLower() != "close";
+        const auto message = serialize(respond(request), keepAlive);
+        const auto delay = options.latency + QRandomGenerator::global()->bounded(options.jitter + 1);
+
+        QTimer::singleShot(delay, socket, [socket, message, keepAlive]
+        {
+            socket->write(message);
+            if (!keepAlive)
+                socket->disconnectFromHost();
+        });
+    }
+}
+
+MockSpotifyServer::Response MockSpotifyServer::respond(const Request& request)
+{
+    // Requests are counted by endpoint, IDs in paths of images are left out.
+    {
+        QMutexLocker locker(&mutex);
+        ++counts[request.path.startsWith("/image/") ? QString("/image") : request.path];
+    }
+
+    if (request.path == "/api/token")
+    {
+        if (request.method != "POST")
+            return error(405, "Method not allowed");
+
+        return {.body = Fixtures::tokenResponse()};
+    }
+
+    if (request.path.startsWith("/image/"))
+        return {.body = Fixtures::image(), .contentType = "image/jpeg"};
+
+    if (!request.path.startsWith("/v1/"))
+        return error(404, "Service not found");
+
+    if (!request.headers.value("authorization").startsWith("Bearer "))
+        return error(401, "No token provided");
+
+    // Failures hit every endpoint of the Web API alike, as they do on the real server.
+    if (const auto roll = QRandomGenerator::global()->generateDouble(); roll < options.rateLimitRate)
+    {
+        auto response = error(429, "API rate limit exceeded");
+        response.headers.append({"Retry-After", QByteArray::number(options.retryAfter)});
+        return response;
+    }
+    else if (roll < options.rateLimitRate + options.errorRate)
+        return error(500, "Server error");
+
+    if (request.path == "/v1/search")
+    {
+        const auto query = request.query.queryItemValue("q", QUrl::FullyDecoded);
+        const auto types = request.query.queryItemValue("type").split(',', Qt::SkipEmptyParts);
+        const auto limit = request.query.queryItemValue("limit").toInt();
+        const auto offset = request.query.queryItemValue("offset").toInt();
+
+        if (query.isEmpty() || types.isEmpty() || limit < 1 || limit > 50)
+            return error(400, "Bad search request");
+
+        Response response{.body = Fixtures::searchResponse(query, types, limit, offset, url())};
+        const auto etag = '"' + QCryptographicHash::hash(response.body, QCryptographicHash::Md5).toHex() + '"';
+        response.headers.append({"ETag", etag});
+
+        if (request.headers.value("if-none-match") == etag)
+        {
+            response.status = 304;
+            response.body.clear();
+        }
+
+        return response;
+    }
+
+    if (request.path == "/v1/me/player/devices")
+        return {.body = Fixtures::devicesResponse(options.devices)};
+
+    if (request.path == "/v1/me/player/play" && request.method == "PUT")
+        return {.status = 204};
+
+    if (request.path == "/v1/me/player/queue" && request.method == "POST")
+        return {.status = 204};
+
+    return error(404, "Service not found");
+}
+
+MockSpotifyServer::Response MockSpotifyServer::error(const int status, const QString& message)
+{
+    return {
+        .status = status,
+        .body = QString(R"({"error":{"status":%1,"message":"%2"}})").arg(status).arg(message).toUtf8()
+    };
+}
+
+QByteArray MockSpotifyServer::serialize(const Response& response, const bool keepAlive)
+{
+    auto message = "HTTP/1.1 " + QByteArray::number(response.status) + ' '
+                   + REASONS.value(response.status, "Error") + "\r\n";
+
+    // Responses without a body have neither content type nor length.
+    if (response.status != 204 && response.status != 304)
+    {
+        message += "Content-Type: " + response.contentType + "\r\n";
+        message += "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n";
+    }
+
+    for (const auto& [name, value] : response.headers)
+        message += name + ": " + value + "\r\n";
+
+    message += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    return message + response.body;
+}
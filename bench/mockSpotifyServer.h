@@ -0,0 +1,115 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QUrlQuery>
+#include <utility>
+class QCommandLineParser;
+class QTcpServer;
+class QTcpSocket;
+
+
+/**
+ * Local stand-in for the Spotify accounts server, the Web API and the image CDN.
+ *
+ * It serves the token, search, devices, play, queue and image endpoints used by the client
+ * over plain HTTP/1.1 with keep-alive, on a thread of its own. Responses are delayed by
+ * a configurable latency with jitter, and Web API responses fail with 500 or 429 Too Many
+ * Requests at configurable rates. Search responses carry ETags and are answered 304 Not
+ * Modified on revalidation. Point the client at it with ALBERT_SPOTIFY_API_URL and
+ * ALBERT_SPOTIFY_ACCOUNTS_URL set to its URL.
+ */
+class MockSpotifyServer
+{
+public:
+    struct Options
+    {
+        int latency = 30;           // Base delay of responses in milliseconds
+        int jitter = 20;            // Maximum random delay added to the base delay in milliseconds
+        double errorRate = 0;       // Share of Web API responses failing with 500
+        double rateLimitRate = 0;   // Share of Web API responses failing with 429
+        int retryAfter = 1;         // Retry-After of rate limited responses in seconds
+        int devices = 3;            // Number of devices of the user
+    };
+
+    explicit MockSpotifyServer(const Options& options);
+    ~MockSpotifyServer();
+
+    /**
+     * Add command line options of the server, e.g. its latency and error rates, to a parser.
+     */
+    static void addOptions(QCommandLineParser& parser);
+
+    /**
+     * Returns options of the server given on the command line.
+     * @param parser The parser that processed the command line.
+     */
+    static Options readOptions(const QCommandLineParser& parser);
+
+    /**
+     * Start listening on the loopback interface.
+     * @param port Port to listen on, zero picks any free one.
+     * @return true if the server listens.
+     */
+    bool start(quint16 port = 0);
+
+    /**
+     * Returns base URL of the server, e.g. http://127.0.0.1:8899.
+     */
+    QString url() const;
+
+    /**
+     * Returns numbers of requests received so far, by path up to the first ID.
+     */
+    QHash<QString, quint64> requestCounts() const;
+
+private:
+    struct Request
+    {
+        QByteArray method;
+        QString path;
+        QUrlQuery query;
+        QHash<QByteArray, QByteArray> headers;  // Lowercased names
+    };
+
+    struct Response
+    {
+        int status = 200;
+        QByteArray body;
+        QByteArray contentType = "application/json; charset=utf-8";
+        QList<std::pair<QByteArray, QByteArray>> headers;
+    };
+
+    const Options options;
+    QThread thread;
+    QTcpServer* server = nullptr;  // Lives on the thread of the server
+    quint16 port = 0;
+
+    mutable QMutex mutex;
+    QHash<QString, quint64> counts;
+
+    /**
+     * Take all complete requests out of the buffer of a connection and answer them.
+     */
+    void serve(QTcpSocket* socket, QByteArray& buffer);
+
+    /**
+     * Returns the response to a request.
+     */
+    Response respond(const Request& request);
+
+    /**
+     * Returns a response of a failed Web API request in the format of Spotify.
+     */
+    static Response error(int status, const QString& message);
+
+    /**
+     * Serialize a response to an HTTP/1.1 message.
+     */
+    static QByteArray serialize(const Response& response, bool keepAlive);
+};
@@ -0,0 +1,84 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "benchmark.h"
+#include "fixtures.h"
+#include "searchParser.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <iostream>
+using namespace std;
+
+inline QStringList TRACK_TYPES = {"track"};
+inline QStringList ALL_TYPES = {"track", "album", "artist", "playlist"};
+
+
+/**
+ * Parse tracks of a search response the way the client did before the pull parser,
+ * through a QString, a JSON document and repeated lookups of the album object.
+ */
+static QVector<Track> parseWithDocument(const QByteArray& body)
+{
+    const auto items = QJsonDocument::fromJson(QString::fromUtf8(body).toUtf8())
+                           .object()["tracks"].toObject()["items"].toArray();
+
+    QVector<Track> tracks;
+
+    for (const auto& item : items)
+    {
+        const auto trackData = item.toObject();
+        auto track = Track();
+
+        QStringList artists;
+        for (const auto& artist : trackData["artists"].toArray())
+            artists.append(artist["name"].toString());
+
+        track.id = trackData["id"].toString();
+        track.name = trackData["name"].toString();
+        track.artists = artists.join(", ");
+        track.albumId = trackData["album"].toObject()["id"].toString();
+        track.albumName = trackData["album"].toObject()["name"].toString();
+        track.uri = trackData["uri"].toString();
+        track.imageUrl = trackData["album"].toObject()["images"].toArray()[2].toObject()["url"].toString();
+        track.isExplicit = trackData["explicit"].toBool();
+
+        tracks.append(track);
+    }
+
+    return tracks;
+}
+
+/**
+ * Cost of parsing search responses by the pull parser compared to a JSON document.
+ */
+int main()
+{
+    cout << "Search responses of tracks" << endl;
+
+    for (const auto limit : {5, 20, 50})
+    {
+        const auto body = Fixtures::searchResponse("radiohead", TRACK_TYPES, limit);
+        const auto name = QString("%1 tracks, %2 kB").arg(limit).arg(body.size() / 1024);
+
+        const auto document = Benchmark::run("document " + name, [&] { return parseWithDocument(body); });
+        const auto pull = Benchmark::run("pull parser " + name, [&] { return SearchParser::parse(body); });
+
+        cout << QString("  speedup %1×, %2× fewer allocations")
+                    .arg(document.nsecs / pull.nsecs, 0, 'f', 1)
+                    .arg(document.allocations / max(pull.allocations, 1.0), 0, 'f', 1)
+                    .toStdString()
+             << endl;
+    }
+
+    // A document would have to be walked for every type, the pull parser reads them in one pass.
+    cout << "Search responses of all types" << endl;
+
+    for (const auto limit : {5, 20, 50})
+    {
+        const auto body = Fixtures::searchResponse("radiohead", ALL_TYPES, limit);
+        Benchmark::run(QString("pull parser %1 of each, %2 kB").arg(limit).arg(body.size() / 1024),
+                       [&] { return SearchParser::parse(body); });
+    }
+
+    return 0;
+}
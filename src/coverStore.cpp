@@ -0,0 +1,108 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "coverStore.h"
+#include <QDir>
+#include <QFile>
+#include <albert/logging.h>
+Q_DECLARE_LOGGING_CATEGORY(AlbertLoggingCategory)
+using namespace std;
+
+inline auto COVER_SUFFIX = QStringLiteral(".jpeg");
+
+
+void CoverStore::setDirectory(const QString& path)
+{
+    QMutexLocker locker(&mutex);
+
+    directory = path;
+    entries.clear();
+    index.clear();
+    totalSize = 0;
+
+    QDir dir(path);
+    if (!dir.exists() && !dir.mkpath("."))
+    {
+        WARN << "Failed to create the covers directory:" << path;
+        return;
+    }
+
+    // The order of use is not persisted, recently downloaded covers are kept the longest.
+    for (const auto& info : dir.entryInfoList({"*" + COVER_SUFFIX}, QDir::Files, QDir::Time))
+    {
+        entries.push_back({info.completeBaseName(), info.size()});
+        index.insert(entries.back().albumId, prev(entries.end()));
+        totalSize += info.size();
+    }
+
+    evict();
+}
+
+void CoverStore::setMaxSize(const qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    maxSize = bytes;
+    evict();
+}
+
+QString CoverStore::path(const QString& albumId) const
+{
+    QMutexLocker locker(&mutex);
+    return QString("%1/%2%3").arg(directory, albumId, COVER_SUFFIX);
+}
+
+bool CoverStore::contains(const QString& albumId)
+{
+    QMutexLocker locker(&mutex);
+
+    const auto it = index.find(albumId);
+    if (it == index.end())
+        return false;
+
+    entries.splice(entries.begin(), entries, it.value());
+    return true;
+}
+
+void CoverStore::add(const QString& filePath, const qint64 size)
+{
+    QMutexLocker locker(&mutex);
+
+    if (directory.isEmpty() || !filePath.startsWith(directory + '/') || !filePath.endsWith(COVER_SUFFIX))
+        return;
+
+    const auto albumId = filePath.sliced(directory.size() + 1).chopped(COVER_SUFFIX.size());
+
+    if (const auto it = index.find(albumId); it != index.end())
+    {
+        totalSize -= it.value()->size;
+        entries.erase(it.value());
+        index.erase(it);
+    }
+
+    entries.push_front({albumId, size});
+    index.insert(albumId, entries.begin());
+    totalSize += size;
+
+    evict();
+}
+
+qint64 CoverStore::size() const
+{
+    QMutexLocker locker(&mutex);
+    return totalSize;
+}
+
+void CoverStore::evict()
+{
+    // The most recent cover is kept even if it exceeds the limit on its own.
+    while (totalSize > maxSize && entries.size() > 1)
+    {
+        const auto& entry = entries.back();
+
+        if (!QFile::remove(QString("%1/%2%3").arg(directory, entry.albumId, COVER_SUFFIX)))
+            DEBG << "Failed to remove the cover of album" << entry.albumId;
+
+        totalSize -= entry.size;
+        index.remove(entry.albumId);
+        entries.pop_back();
+    }
+}
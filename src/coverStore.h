@@ -0,0 +1,76 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <limits>
+#include <list>
+
+
+/**
+ * Size-capped directory of album cover images, one file per album.
+ *
+ * The directory is scanned once, afterwards an in-memory index answers whether a cover
+ * is present, so building result items costs no filesystem access. Once the covers exceed
+ * the maximum size, the least recently used ones are deleted. Covers stay plain files,
+ * because Albert loads item icons from file paths.
+ */
+class CoverStore
+{
+public:
+    /**
+     * Set the directory of the covers, create it if missing and index the covers in it.
+     * Covers modified recently are considered used recently.
+     * @param path Path to the directory.
+     */
+    void setDirectory(const QString& path);
+
+    /**
+     * Set maximum total size of the covers, evicting covers over the limit.
+     * @param bytes Maximum size in bytes.
+     */
+    void setMaxSize(qint64 bytes);
+
+    /**
+     * Returns path of the cover of the album, whether it exists or not.
+     */
+    QString path(const QString& albumId) const;
+
+    /**
+     * Returns true if the cover of the album is stored and marks it as the most recently used one.
+     */
+    bool contains(const QString& albumId);
+
+    /**
+     * Index a cover saved to the given path, evicting the least recently used covers if full.
+     * Files outside of the directory are ignored.
+     * @param filePath Path of the saved file.
+     * @param size Size of the file in bytes.
+     */
+    void add(const QString& filePath, qint64 size);
+
+    /**
+     * Returns total size of the stored covers in bytes.
+     */
+    qint64 size() const;
+
+private:
+    struct Entry
+    {
+        QString albumId;
+        qint64 size;
+    };
+
+    mutable QMutex mutex;
+    QString directory;
+    qint64 maxSize = std::numeric_limits<qint64>::max();
+    qint64 totalSize = 0;
+    std::list<Entry> entries;  // Most recently used first
+    QHash<QString, std::list<Entry>::iterator> index;
+
+    /**
+     * Delete least recently used covers until the total size fits. Expects the mutex.
+     */
+    void evict();
+};
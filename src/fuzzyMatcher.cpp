@@ -0,0 +1,305 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "fuzzyMatcher.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+using namespace std;
+
+inline float FUZZY_MIN_SIMILARITY = 0.6f;  // Dice coefficient of bigrams a misspelled word needs
+inline float FUZZY_MIN_SHARED = 0.6f;      // Share of bigrams of a misspelled word a key word has to contain
+inline float FUZZY_PENALTY = 0.8f;         // Score of a misspelled word relative to an exact one
+inline float INFIX_PENALTY = 0.9f;         // Score of a word found in the middle of another word
+
+struct FuzzyMatcher::Word
+{
+    string_view text;
+    QVector<quint16> bits;  // Bits of the word in the key signatures
+    int required;           // Bits a key signature has to share with the word to be scored at all
+    quint64 signature;      // Signature compared with signatures of single key words
+    int signatureRequired;  // Bits a key word has to share with the word to be compared
+};
+
+
+/**
+ * Returns true for ASCII characters which are not part of words, bytes of multibyte characters are.
+ */
+static bool isSeparator(const char c)
+{
+    const auto byte = static_cast<unsigned char>(c);
+    return byte < 0x80 && static_cast<unsigned char>((byte | 0x20) - 'a') >= 26
+                       && static_cast<unsigned char>(byte - '0') >= 10;
+}
+
+/**
+ * Call a function for each word of the text.
+ */
+template<typename Function>
+static void forEachWord(const string_view text, Function&& function)
+{
+    size_t start = 0;
+    while (start < text.size())
+    {
+        while (start < text.size() && isSeparator(text[start]))
+            ++start;
+
+        auto end = start;
+        while (end < text.size() && !isSeparator(text[end]))
+            ++end;
+
+        if (end > start)
+            function(text.substr(start, end - start));
+
+        start = end;
+    }
+}
+
+/**
+ * Call a function with a 32-bit hash of each bigram of the text, bigrams spanning separators are left out.
+ */
+template<typename Function>
+static void forEachBigram(const string_view text, Function&& function)
+{
+    for (size_t i = 1; i < text.size(); ++i)
+        if (!isSeparator(text[i - 1]) && !isSeparator(text[i]))
+            function((quint32(quint8(text[i - 1])) << 8 | quint8(text[i])) * 0x9e3779b1u);
+}
+
+/**
+ * Returns set of bigrams of a key hashed to 512 bits.
+ */
+static FuzzyMatcher::Signature keySignature(const string_view key)
+{
+    auto bits = FuzzyMatcher::Signature();
+
+    forEachBigram(key, [&bits](const quint32 hash)
+    {
+        const auto bit = hash >> 23;
+        bits[bit / 64] |= quint64(1) << (bit % 64);
+    });
+
+    return bits;
+}
+
+/**
+ * Returns set of bigrams of a single word hashed to 64 bits.
+ */
+static quint64 wordSignature(const string_view word)
+{
+    quint64 bits = 0;
+    forEachBigram(word, [&bits](const quint32 hash) { bits |= quint64(1) << (hash >> 26); });
+    return bits;
+}
+
+/**
+ * Returns Dice coefficient of bigrams of two words, zero if they do not share enough bigrams.
+ */
+static float similarity(const string_view a, const string_view b)
+{
+    // A single character has no bigrams, it has to match exactly.
+    if (a.size() < 2 || b.size() < 2)
+        return 0.f;
+
+    const auto aBigrams = a.size() - 1;
+    const auto bBigrams = min<size_t>(b.size() - 1, 64);
+
+    // Words of too different lengths can not share enough bigrams.
+    if (2.f * min(aBigrams, bBigrams) < FUZZY_MIN_SIMILARITY * (aBigrams + bBigrams)
+        || bBigrams < FUZZY_MIN_SHARED * aBigrams)
+        return 0.f;
+
+    quint64 used = 0;  // Bigrams of b matched already, each one counts once
+    size_t common = 0;
+
+    for (size_t i = 0; i < aBigrams; ++i)
+        for (size_t j = 0; j < bBigrams; ++j)
+            if (!(used >> j & 1) && a[i] == b[j] && a[i + 1] == b[j + 1])
+            {
+                used |= quint64(1) << j;
+                ++common;
+                break;
+            }
+
+    if (common < FUZZY_MIN_SHARED * aBigrams)
+        return 0.f;
+
+    return 2.f * common / static_cast<float>(aBigrams + bBigrams);
+}
+
+
+void FuzzyMatcher::clear()
+{
+    text.clear();
+    offsets = {0};
+    for (auto& lane : signatures)
+        lane.clear();
+
+    wordOffsets = {0};
+    wordStarts.clear();
+    wordSizes.clear();
+    wordSignatures.clear();
+}
+
+void FuzzyMatcher::reserve(const qsizetype keys, const qsizetype bytes)
+{
+    text.reserve(bytes);
+    offsets.reserve(keys + 1);
+    for (auto& lane : signatures)
+        lane.reserve(keys);
+
+    wordOffsets.reserve(keys + 1);
+}
+
+void FuzzyMatcher::append(const string_view key)
+{
+    const auto start = static_cast<quint32>(text.size());
+
+    text.append(key.data(), static_cast<qsizetype>(key.size()));
+    offsets.append(static_cast<quint32>(text.size()));
+
+    const auto bits = keySignature(key);
+    for (qsizetype lane = 0; lane < SIGNATURE_LANES; ++lane)
+        signatures[lane].append(bits[lane]);
+
+    forEachWord(key, [&](const string_view word)
+    {
+        wordStarts.append(start + static_cast<quint32>(word.data() - key.data()));
+        wordSizes.append(static_cast<quint8>(min<size_t>(word.size(), 255)));
+        wordSignatures.append(wordSignature(word));
+    });
+
+    wordOffsets.append(static_cast<quint32>(wordStarts.size()));
+}
+
+qsizetype FuzzyMatcher::size() const { return offsets.size() - 1; }
+
+QVector<quint32> FuzzyMatcher::match(const QString& query, const qsizetype limit) const
+{
+    const auto utf8 = query.toLower().toUtf8();
+
+    QVector<Word> words;
+    forEachWord(string_view(utf8.constData(), utf8.size()), [&words](const string_view text)
+    {
+        auto word = Word{.text = text, .bits = {}, .required = 0, .signature = wordSignature(text),
+                         .signatureRequired = 0};
+
+        const auto bits = keySignature(text);
+        for (int bit = 0; bit < SIGNATURE_LANES * 64; ++bit)
+            if (bits[bit / 64] >> (bit % 64) & 1)
+                word.bits.append(static_cast<quint16>(bit));
+
+        word.required = static_cast<int>(ceil(word.bits.size() * FUZZY_MIN_SHARED));
+        word.signatureRequired = static_cast<int>(ceil(popcount(word.signature) * FUZZY_MIN_SHARED));
+        words.append(word);
+    });
+
+    if (words.isEmpty() || limit <= 0)
+        return {};
+
+    // Keys not sharing enough bigrams with every word are dropped by their signatures first.
+    // Bits of the word are counted one lane column after another, the loops run over contiguous
+    // arrays without branches and compile to plain vector instructions on any target.
+    const auto count = size();
+    QVector<quint8> passes(count, 1);
+    QVector<quint16> shared(count);
+    auto* passed = passes.data();
+    auto* counts = shared.data();
+
+    for (const auto& word : words)
+    {
+        if (word.required == 0)
+            continue;
+
+        shared.fill(0);
+
+        for (const auto bit : word.bits)
+        {
+            const auto* lane = signatures[bit / 64].constData();
+            const auto shift = bit % 64;
+
+            for (qsizetype i = 0; i < count; ++i)
+                counts[i] += static_cast<quint16>(lane[i] >> shift & 1);
+        }
+
+        for (qsizetype i = 0; i < count; ++i)
+            passed[i] &= counts[i] >= word.required;
+    }
+
+    struct Scored
+    {
+        quint32 index;
+        float score;
+    };
+
+    QVector<Scored> scored;
+    const auto perfectScore = static_cast<float>(words.size());
+    qsizetype perfect = 0;
+
+    // Keys are scored in their order, so once there are enough perfect matches no later key can rank higher.
+    for (qsizetype i = 0; i < count && perfect < limit; ++i)
+    {
+        if (!passed[i])
+            continue;
+
+        float total = 0.f;
+        for (const auto& word : words)
+        {
+            const auto wordScore = score(i, word);
+            if (wordScore == 0.f)
+            {
+                total = 0.f;
+                break;
+            }
+            total += wordScore;
+        }
+
+        if (total == perfectScore)
+            ++perfect;
+
+        if (total > 0.f)
+            scored.append(Scored{static_cast<quint32>(i), total / perfectScore});
+    }
+
+    // Equally good matches keep the order of the keys.
+    const auto top = scored.begin() + min(limit, scored.size());
+    partial_sort(scored.begin(), top, scored.end(), [](const Scored& a, const Scored& b)
+                 { return a.score > b.score || (a.score == b.score && a.index < b.index); });
+
+    QVector<quint32> indexes;
+    indexes.reserve(top - scored.begin());
+    for (auto it = scored.begin(); it != top; ++it)
+        indexes.append(it->index);
+
+    return indexes;
+}
+
+string_view FuzzyMatcher::key(const qsizetype index) const
+{
+    return {text.constData() + offsets[index], offsets[index + 1] - offsets[index]};
+}
+
+float FuzzyMatcher::score(const qsizetype index, const Word& word) const
+{
+    const auto key = this->key(index);
+
+    if (auto pos = key.find(word.text); pos != string_view::npos)
+    {
+        // Typing the beginning of a word is the most common case, so such matches rank first.
+        for (; pos != string_view::npos; pos = key.find(word.text, pos + 1))
+            if (pos == 0 || isSeparator(key[pos - 1]))
+                return 1.f;
+
+        return INFIX_PENALTY;
+    }
+
+    if (word.signatureRequired == 0)
+        return 0.f;
+
+    // Only key words sharing enough bigram bits with the word are compared precisely.
+    float best = 0.f;
+    for (auto w = wordOffsets[index]; w < wordOffsets[index + 1]; ++w)
+        if (popcount(wordSignatures[w] & word.signature) >= word.signatureRequired)
+            best = max(best, similarity(word.text, {text.constData() + wordStarts[w], wordSizes[w]}));
+
+    return best >= FUZZY_MIN_SIMILARITY ? best * FUZZY_PENALTY : 0.f;
+}
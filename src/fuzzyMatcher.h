@@ -0,0 +1,83 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <array>
+#include <string_view>
+
+
+/**
+ * Typo tolerant matcher of queries against a set of lowercased UTF-8 keys.
+ *
+ * Keys are stored in a columnar layout: one contiguous text buffer with offsets and
+ * columns of 512-bit bigram signatures. A query is first checked against the signatures
+ * only, which are tight branchless loops over contiguous arrays, and just the few remaining
+ * keys are scored word by word. A query word matches a key if it is a substring of it
+ * or if it shares enough bigrams with one of its words, so "radiohed crep" still finds
+ * "creep radiohead pablo honey". Signatures of single key words are kept as well, so
+ * a misspelled word is compared precisely only with key words of similar bigrams.
+ */
+class FuzzyMatcher
+{
+public:
+    static constexpr qsizetype SIGNATURE_LANES = 8;
+
+    /**
+     * Set of hashed bigrams of a text.
+     */
+    using Signature = std::array<quint64, SIGNATURE_LANES>;
+
+    /**
+     * Remove all keys.
+     */
+    void clear();
+
+    /**
+     * Reserve space for the given number of keys of the given total size.
+     */
+    void reserve(qsizetype keys, qsizetype bytes);
+
+    /**
+     * Append a key, keys are identified by the order they were appended in.
+     * @param key Lowercased UTF-8 key.
+     */
+    void append(std::string_view key);
+
+    /**
+     * Returns the number of keys.
+     */
+    qsizetype size() const;
+
+    /**
+     * Find keys matching all words of the query.
+     * @param query The search query.
+     * @param limit The maximum number of keys to return.
+     * @return Indexes of the best matching keys, best first, equally good in the order of appending.
+     */
+    QVector<quint32> match(const QString& query, qsizetype limit) const;
+
+private:
+    struct Word;
+
+    QByteArray text;
+    QVector<quint32> offsets = {0};
+    std::array<QVector<quint64>, SIGNATURE_LANES> signatures;  // One column per 64-bit lane
+
+    // Words of all keys, a misspelled query word is compared with them one by one.
+    QVector<quint32> wordOffsets = {0};  // First word of each key
+    QVector<quint32> wordStarts;         // Offsets of the words in the text
+    QVector<quint8> wordSizes;
+    QVector<quint64> wordSignatures;     // 64-bit bigram signatures of the words
+
+    /**
+     * Returns the key at the given index.
+     */
+    std::string_view key(qsizetype index) const;
+
+    /**
+     * Returns score of a query word in the key at the given index, zero if it does not match.
+     */
+    float score(qsizetype index, const Word& word) const;
+};
@@ -0,0 +1,146 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "httpDiskCache.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <albert/logging.h>
+Q_DECLARE_LOGGING_CATEGORY(AlbertLoggingCategory)
+using namespace std;
+
+inline quint32 CACHE_FILE_MAGIC = 0x53504843;  // "SPHC"
+inline quint32 CACHE_FILE_VERSION = 1;
+
+
+void HttpDiskCache::setDirectory(const QString& path)
+{
+    QMutexLocker locker(&mutex);
+
+    directory = path;
+    files.clear();
+    index.clear();
+    totalSize = 0;
+
+    if (directory.isEmpty())
+        return;
+
+    QDir dir(directory);
+    if (!dir.exists() && !dir.mkpath("."))
+    {
+        WARN << "Failed to create the responses directory:" << directory;
+        return;
+    }
+
+    // Entries are rewritten on every revalidation, so the modification time tells when they were stored.
+    for (const auto& info : dir.entryInfoList(QDir::Files, QDir::Time))
+    {
+        files.push_back({info.fileName(), info.size(), info.lastModified().toMSecsSinceEpoch()});
+        index.insert(files.back().name, prev(files.end()));
+        totalSize += info.size();
+    }
+
+    evict();
+}
+
+void HttpDiskCache::setMaxSize(const qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    maxSize = bytes;
+    evict();
+}
+
+void HttpDiskCache::setMaxAge(const qint64 msecs)
+{
+    QMutexLocker locker(&mutex);
+    maxAge = msecs;
+    evict();
+}
+
+std::optional<HttpDiskCache::Entry> HttpDiskCache::load(const QString& key) const
+{
+    QMutexLocker locker(&mutex);
+
+    if (directory.isEmpty())
+        return std::nullopt;
+
+    QFile file(QDir(directory).filePath(fileName(key)));
+    if (!file.open(QIODevice::ReadOnly))
+        return std::nullopt;
+
+    QDataStream stream(&file);
+    quint32 magic, version;
+    stream >> magic >> version;
+
+    if (magic != CACHE_FILE_MAGIC || version != CACHE_FILE_VERSION)
+        return std::nullopt;
+
+    Entry entry;
+    stream >> entry.etag >> entry.timestamp >> entry.body;
+
+    if (stream.status() != QDataStream::Ok)
+        return std::nullopt;
+
+    return entry;
+}
+
+void HttpDiskCache::store(const QString& key, const Entry& entry)
+{
+    QMutexLocker locker(&mutex);
+
+    if (directory.isEmpty())
+        return;
+
+    const auto name = fileName(key);
+    const auto path = QDir(directory).filePath(name);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream stream(&file);
+    stream << CACHE_FILE_MAGIC << CACHE_FILE_VERSION << entry.etag << entry.timestamp << entry.body;
+    if (!file.commit())
+        return;
+
+    if (const auto it = index.find(name); it != index.end())
+    {
+        totalSize -= it.value()->size;
+        files.erase(it.value());
+        index.erase(it);
+    }
+
+    const auto size = QFileInfo(path).size();
+    files.push_front({name, size, QDateTime::currentMSecsSinceEpoch()});
+    index.insert(name, files.begin());
+    totalSize += size;
+
+    evict();
+}
+
+void HttpDiskCache::evict()
+{
+    const auto now = QDateTime::currentMSecsSinceEpoch();
+
+    // The most recent entry is kept even if it exceeds the size limit on its own.
+    while (!files.empty()
+           && (now - files.back().stored > maxAge || (totalSize > maxSize && files.size() > 1)))
+    {
+        const auto& file = files.back();
+
+        if (!QFile::remove(QDir(directory).filePath(file.name)))
+            DEBG << "Failed to remove the cached response" << file.name;
+
+        totalSize -= file.size;
+        index.remove(file.name);
+        files.pop_back();
+    }
+}
+
+QString HttpDiskCache::fileName(const QString& key)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex());
+}
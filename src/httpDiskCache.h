@@ -0,0 +1,88 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <limits>
+#include <list>
+#include <optional>
+
+
+/**
+ * Persistent cache of HTTP response bodies along with their ETags.
+ * Every entry is stored in its own file named by a hash of the key.
+ * Entries older than the maximum age are deleted, and once the entries exceed
+ * the maximum size, the least recently stored ones are deleted as well.
+ */
+class HttpDiskCache
+{
+public:
+    struct Entry
+    {
+        QByteArray body;
+        QByteArray etag;
+        qint64 timestamp = 0;  // Time of the last (re)validation in msecs since epoch
+    };
+
+    /**
+     * Set directory where the entries are stored, an empty path disables the cache.
+     * @param path Path to the directory, it is created if it does not exist.
+     */
+    void setDirectory(const QString& path);
+
+    /**
+     * Set maximum total size of the entries, evicting entries over the limit.
+     * @param bytes Maximum size in bytes.
+     */
+    void setMaxSize(qint64 bytes);
+
+    /**
+     * Set maximum age of the entries, evicting older entries.
+     * @param msecs Maximum time since an entry was stored in milliseconds.
+     */
+    void setMaxAge(qint64 msecs);
+
+    /**
+     * Load an entry from the cache.
+     * @param key The key of the entry, usually the request URL.
+     * @return The entry or nothing if it is not cached.
+     */
+    std::optional<Entry> load(const QString& key) const;
+
+    /**
+     * Store an entry in the cache, replacing the previous one.
+     * @param key The key of the entry, usually the request URL.
+     * @param entry The entry to store.
+     */
+    void store(const QString& key, const Entry& entry);
+
+private:
+    struct File
+    {
+        QString name;
+        qint64 size;
+        qint64 stored;  // Time of the last store in msecs since epoch
+    };
+
+    mutable QMutex mutex;
+    QString directory;
+    qint64 maxSize = std::numeric_limits<qint64>::max();
+    qint64 maxAge = std::numeric_limits<qint64>::max();
+    qint64 totalSize = 0;
+    std::list<File> files;  // Most recently stored first
+    QHash<QString, std::list<File>::iterator> index;
+
+    /**
+     * Delete entries over the maximum age and the least recently stored ones
+     * until the total size fits. Expects the mutex.
+     */
+    void evict();
+
+    /**
+     * Returns name of the file holding an entry.
+     * @param key The key of the entry.
+     */
+    static QString fileName(const QString& key);
+};
@@ -0,0 +1,303 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "jsonReader.h"
+#include <cstring>
+using namespace std;
+
+
+JsonReader::JsonReader(const QByteArrayView json):
+    pos(json.data()),
+    end(json.data() + json.size())
+{
+}
+
+bool JsonReader::hasError() const { return error; }
+
+bool JsonReader::enterObject()
+{
+    if (consume('{'))
+        return true;
+
+    skip();
+    return false;
+}
+
+bool JsonReader::nextMember(string_view& key)
+{
+    skipWhitespace();
+
+    if (pos == end)
+    {
+        error = true;
+        return false;
+    }
+
+    if (*pos == '}')
+    {
+        ++pos;
+        return false;
+    }
+
+    consume(',');
+
+    if (!consume('"'))
+    {
+        error = true;
+        pos = end;
+        return false;
+    }
+
+    // Keys of the Web API never contain escapes, so they are returned raw.
+    const auto begin = pos;
+    skipString();
+    key = string_view(begin, max(pos - 1 - begin, ptrdiff_t(0)));
+
+    if (!consume(':'))
+    {
+        error = true;
+        pos = end;
+        return false;
+    }
+
+    return true;
+}
+
+bool JsonReader::enterArray()
+{
+    if (consume('['))
+        return true;
+
+    skip();
+    return false;
+}
+
+bool JsonReader::nextElement()
+{
+    skipWhitespace();
+
+    if (pos == end)
+    {
+        error = true;
+        return false;
+    }
+
+    if (*pos == ']')
+    {
+        ++pos;
+        return false;
+    }
+
+    consume(',');
+    return true;
+}
+
+QString JsonReader::readString()
+{
+    if (!consume('"'))
+    {
+        skip();
+        return {};
+    }
+
+    const auto begin = pos;
+    bool escaped = false;
+
+    for (; pos < end && *pos != '"'; ++pos)
+    {
+        if (*pos == '\\')
+        {
+            escaped = true;
+            ++pos;
+        }
+    }
+
+    if (pos >= end)
+    {
+        error = true;
+        pos = end;
+        return {};
+    }
+
+    const auto stringEnd = pos++;
+
+    return escaped ? decodeString(begin, stringEnd)
+                   : QString::fromUtf8(begin, stringEnd - begin);
+}
+
+bool JsonReader::readBool()
+{
+    skipWhitespace();
+
+    if (end - pos >= 4 && memcmp(pos, "true", 4) == 0)
+    {
+        pos += 4;
+        return true;
+    }
+
+    skip();
+    return false;
+}
+
+qint64 JsonReader::readInteger()
+{
+    skipWhitespace();
+
+    const auto negative = pos < end && *pos == '-';
+    if (negative)
+        ++pos;
+
+    qint64 value = 0;
+    for (; pos < end && *pos >= '0' && *pos <= '9'; ++pos)
+        value = value * 10 + (*pos - '0');
+
+    // Drop fraction and exponent, if any.
+    skip();
+
+    return negative ? -value : value;
+}
+
+void JsonReader::skip()
+{
+    skipWhitespace();
+
+    if (pos == end)
+        return;
+
+    if (*pos == '"')
+    {
+        ++pos;
+        skipString();
+        return;
+    }
+
+    if (*pos == '{' || *pos == '[')
+    {
+        int depth = 0;
+        while (pos < end)
+        {
+            switch (*pos++)
+            {
+            case '"':
+                skipString();
+                break;
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                if (--depth == 0)
+                    return;
+                break;
+            default:
+                break;
+            }
+        }
+        error = true;
+        return;
+    }
+
+    // Number, boolean or null.
+    while (pos < end && !strchr(",}] \t\r\n", *pos))
+        ++pos;
+}
+
+void JsonReader::skipWhitespace()
+{
+    while (pos < end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t'))
+        ++pos;
+}
+
+void JsonReader::skipString()
+{
+    // Expects the opening quote to be consumed already, stops after the closing one.
+    if (const auto quote = static_cast<const char*>(memchr(pos, '"', end - pos));
+        quote && (quote == pos || quote[-1] != '\\'))
+    {
+        pos = quote + 1;
+        return;
+    }
+
+    for (; pos < end; ++pos)
+    {
+        if (*pos == '\\')
+            ++pos;
+        else if (*pos == '"')
+        {
+            ++pos;
+            return;
+        }
+    }
+
+    error = true;
+}
+
+bool JsonReader::consume(const char c)
+{
+    skipWhitespace();
+
+    if (pos < end && *pos == c)
+    {
+        ++pos;
+        return true;
+    }
+
+    return false;
+}
+
+QString JsonReader::decodeString(const char* begin, const char* end)
+{
+    QString result;
+    result.reserve(end - begin);
+
+    auto chunk = begin;
+    const auto flush = [&](const char* until) { result.append(QString::fromUtf8(chunk, until - chunk)); };
+
+    const auto hex = [](const char* p)
+    {
+        char16_t value = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            const auto c = p[i];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        }
+        return value;
+    };
+
+    for (auto p = begin; p < end; ++p)
+    {
+        if (*p != '\\' || p + 1 >= end)
+            continue;
+
+        flush(p);
+        ++p;
+
+        switch (*p)
+        {
+        case 'b': result.append(u'\b'); break;
+        case 'f': result.append(u'\f'); break;
+        case 'n': result.append(u'\n'); break;
+        case 'r': result.append(u'\r'); break;
+        case 't': result.append(u'\t'); break;
+        case 'u':
+            // Surrogate pairs arrive as two consecutive escapes and are appended one by one.
+            if (end - p > 4)
+            {
+                result.append(QChar(hex(p + 1)));
+                p += 4;
+            }
+            break;
+        default:  // Quote, backslash and slash stand for themselves
+            result.append(QLatin1Char(*p));
+            break;
+        }
+
+        chunk = p + 1;
+    }
+
+    flush(end);
+    return result;
+}
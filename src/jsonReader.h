@@ -0,0 +1,85 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include <QByteArrayView>
+#include <QString>
+#include <string_view>
+
+
+/**
+ * Forward-only pull reader of UTF-8 encoded JSON.
+ * It reads values in place without building a document, so callers can
+ * pick the fields they need and skip everything else.
+ * Every value has to be consumed by one of the read, enter or skip methods
+ * before advancing to the next member or element.
+ */
+class JsonReader
+{
+public:
+    explicit JsonReader(QByteArrayView json);
+
+    /**
+     * Returns true if the input turned out to be malformed.
+     */
+    bool hasError() const;
+
+    /**
+     * Enter an object to iterate over its members with nextMember.
+     * Values of other types, e.g. null, are skipped.
+     * @return true if the value is an object.
+     */
+    bool enterObject();
+
+    /**
+     * Advance to the value of the next member of the current object.
+     * @param key Set to the raw key of the member.
+     * @return false if the end of the object was reached.
+     */
+    bool nextMember(std::string_view& key);
+
+    /**
+     * Enter an array to iterate over its elements with nextElement.
+     * Values of other types, e.g. null, are skipped.
+     * @return true if the value is an array.
+     */
+    bool enterArray();
+
+    /**
+     * Advance to the next element of the current array.
+     * @return false if the end of the array was reached.
+     */
+    bool nextElement();
+
+    /**
+     * Read a string value, values of other types are skipped.
+     * @return The decoded string or an empty string.
+     */
+    QString readString();
+
+    /**
+     * Read a boolean value, values of other types are skipped.
+     * @return The value or false.
+     */
+    bool readBool();
+
+    /**
+     * Read an integer value, values of other types are skipped.
+     * @return The value or zero.
+     */
+    qint64 readInteger();
+
+    /**
+     * Skip the current value including all nested values.
+     */
+    void skip();
+
+private:
+    const char* pos;
+    const char* end;
+    bool error = false;
+
+    void skipWhitespace();
+    void skipString();
+    bool consume(char c);
+    static QString decodeString(const char* begin, const char* end);
+};
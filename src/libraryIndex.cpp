@@ -0,0 +1,267 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "libraryIndex.h"
+#include <QHash>
+#include <QSaveFile>
+#include <unordered_set>
+using namespace std;
+
+inline quint32 INDEX_FILE_MAGIC = 0x5350494c;  // "SPIL"
+inline quint32 INDEX_FILE_VERSION = 1;
+inline quint32 TRACK_EXPLICIT = 0x1;
+
+// Records are read in place from the mapped file, so they consist of 32-bit fields only.
+struct LibraryIndex::StringRef
+{
+    quint32 offset;
+    quint32 size;
+};
+
+struct LibraryIndex::Header
+{
+    quint32 magic;
+    quint32 version;
+    quint32 sourceCount;
+    quint32 trackCount;
+    quint32 stringsSize;
+    quint32 reserved;
+};
+
+struct LibraryIndex::SourceRecord
+{
+    StringRef key;
+    StringRef fingerprint;
+    quint32 firstTrack;
+    quint32 trackCount;
+};
+
+struct LibraryIndex::TrackRecord
+{
+    StringRef id;
+    StringRef name;
+    StringRef artists;
+    StringRef albumId;
+    StringRef albumName;
+    StringRef uri;
+    StringRef imageUrl;
+    StringRef searchKey;
+    quint32 flags;
+};
+
+
+void LibraryIndex::setPath(const QString& path)
+{
+    QWriteLocker locker(&lock);
+    this->path = path;
+    open();
+}
+
+bool LibraryIndex::isEmpty() const { return size() == 0; }
+
+qsizetype LibraryIndex::size() const
+{
+    QReadLocker locker(&lock);
+    return header ? header->trackCount : 0;
+}
+
+QVector<Track> LibraryIndex::search(const QString& query, const qsizetype limit) const
+{
+    QReadLocker locker(&lock);
+
+    QVector<Track> tracks;
+    for (const auto key : matcher.match(query, limit))
+        tracks.append(track(trackRecords[matcherTracks[key]]));
+
+    return tracks;
+}
+
+QList<LibraryIndex::Source> LibraryIndex::sources() const
+{
+    QReadLocker locker(&lock);
+
+    if (!header)
+        return {};
+
+    QList<Source> sources;
+    sources.reserve(header->sourceCount);
+
+    for (quint32 i = 0; i < header->sourceCount; ++i)
+    {
+        const auto& record = sourceRecords[i];
+
+        auto source = Source();
+        source.key = string(record.key);
+        source.fingerprint = string(record.fingerprint);
+        source.tracks.reserve(record.trackCount);
+
+        for (quint32 t = record.firstTrack; t < record.firstTrack + record.trackCount && t < header->trackCount; ++t)
+            source.tracks.append(track(trackRecords[t]));
+
+        sources.append(std::move(source));
+    }
+
+    return sources;
+}
+
+bool LibraryIndex::write(const QList<Source>& sources)
+{
+    QByteArray blob;
+    QHash<QString, StringRef> pool;
+
+    // Album, artist and image strings repeat a lot, each distinct one is stored once.
+    const auto addString = [&](const QString& string)
+    {
+        if (const auto it = pool.constFind(string); it != pool.cend())
+            return *it;
+
+        const auto utf8 = string.toUtf8();
+        const auto ref = StringRef{static_cast<quint32>(blob.size()), static_cast<quint32>(utf8.size())};
+        blob.append(utf8);
+        pool.insert(string, ref);
+        return ref;
+    };
+
+    QVector<SourceRecord> sourceTable;
+    QVector<TrackRecord> trackTable;
+
+    for (const auto& source : sources)
+    {
+        sourceTable.append(SourceRecord{
+            .key = addString(source.key),
+            .fingerprint = addString(source.fingerprint),
+            .firstTrack = static_cast<quint32>(trackTable.size()),
+            .trackCount = static_cast<quint32>(source.tracks.size())
+        });
+
+        for (const auto& track : source.tracks)
+        {
+            const auto searchKey = QString("%1 %2 %3").arg(track.name, track.artists, track.albumName).toLower();
+
+            trackTable.append(TrackRecord{
+                .id = addString(track.id),
+                .name = addString(track.name),
+                .artists = addString(track.artists),
+                .albumId = addString(track.albumId),
+                .albumName = addString(track.albumName),
+                .uri = addString(track.uri),
+                .imageUrl = addString(track.imageUrl),
+                .searchKey = addString(searchKey),
+                .flags = track.isExplicit ? TRACK_EXPLICIT : 0
+            });
+        }
+    }
+
+    const auto fileHeader = Header{
+        .magic = INDEX_FILE_MAGIC,
+        .version = INDEX_FILE_VERSION,
+        .sourceCount = static_cast<quint32>(sourceTable.size()),
+        .trackCount = static_cast<quint32>(trackTable.size()),
+        .stringsSize = static_cast<quint32>(blob.size()),
+        .reserved = 0
+    };
+
+    QString indexPath;
+    {
+        QReadLocker locker(&lock);
+        indexPath = path;
+    }
+
+    QSaveFile saveFile(indexPath);
+    if (!saveFile.open(QIODevice::WriteOnly))
+        return false;
+
+    saveFile.write(reinterpret_cast<const char*>(&fileHeader), sizeof(Header));
+    saveFile.write(reinterpret_cast<const char*>(sourceTable.constData()), sourceTable.size() * sizeof(SourceRecord));
+    saveFile.write(reinterpret_cast<const char*>(trackTable.constData()), trackTable.size() * sizeof(TrackRecord));
+    saveFile.write(blob);
+
+    if (!saveFile.commit())
+        return false;
+
+    // Searches hold the read lock, so the old mapping is not dropped under their feet.
+    QWriteLocker locker(&lock);
+    open();
+    return true;
+}
+
+void LibraryIndex::open()
+{
+    header = nullptr;
+    file.reset();
+    matcher.clear();
+    matcherTracks.clear();
+
+    if (path.isEmpty())
+        return;
+
+    auto indexFile = make_unique<QFile>(path);
+    const auto size = indexFile->size();
+
+    if (!indexFile->open(QIODevice::ReadOnly) || size < qint64(sizeof(Header)))
+        return;
+
+    const auto data = indexFile->map(0, size);
+    if (!data)
+        return;
+
+    const auto mappedHeader = reinterpret_cast<const Header*>(data);
+
+    if (mappedHeader->magic != INDEX_FILE_MAGIC || mappedHeader->version != INDEX_FILE_VERSION)
+        return;
+
+    // A truncated or otherwise damaged file is treated as missing.
+    const auto expectedSize = qint64(sizeof(Header))
+                              + qint64(mappedHeader->sourceCount) * qint64(sizeof(SourceRecord))
+                              + qint64(mappedHeader->trackCount) * qint64(sizeof(TrackRecord))
+                              + qint64(mappedHeader->stringsSize);
+
+    if (expectedSize != size)
+        return;
+
+    header = mappedHeader;
+    sourceRecords = reinterpret_cast<const SourceRecord*>(header + 1);
+    trackRecords = reinterpret_cast<const TrackRecord*>(sourceRecords + header->sourceCount);
+    strings = reinterpret_cast<const char*>(trackRecords + header->trackCount);
+    file = std::move(indexFile);
+
+    // Tracks in several sources are matched once, at their first occurrence.
+    unordered_set<string_view> seen;
+    matcher.reserve(header->trackCount, header->stringsSize);
+
+    for (quint32 i = 0; i < header->trackCount; ++i)
+        if (seen.insert(view(trackRecords[i].id)).second)
+        {
+            matcher.append(view(trackRecords[i].searchKey));
+            matcherTracks.append(i);
+        }
+}
+
+string_view LibraryIndex::view(const StringRef& ref) const
+{
+    if (qint64(ref.offset) + ref.size > header->stringsSize)
+        return {};
+
+    return {strings + ref.offset, ref.size};
+}
+
+QString LibraryIndex::string(const StringRef& ref) const
+{
+    const auto utf8 = view(ref);
+    return QString::fromUtf8(utf8.data(), static_cast<qsizetype>(utf8.size()));
+}
+
+Track LibraryIndex::track(const TrackRecord& record) const
+{
+    auto track = Track();
+
+    track.id = string(record.id);
+    track.name = string(record.name);
+    track.artists = string(record.artists);
+    track.albumId = string(record.albumId);
+    track.albumName = string(record.albumName);
+    track.uri = string(record.uri);
+    track.imageUrl = string(record.imageUrl);
+    track.isExplicit = record.flags & TRACK_EXPLICIT;
+
+    return track;
+}
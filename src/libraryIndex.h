@@ -0,0 +1,113 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include "fuzzyMatcher.h"
+#include "types/track.h"
+#include <QFile>
+#include <QList>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include <string_view>
+
+
+/**
+ * Local index of tracks from the users library, searchable without any request.
+ *
+ * The index lives in a single file which is memory-mapped as a whole, so opening it costs
+ * no parsing and only pages touched by a search are read. The file holds fixed-size records
+ * referring to one UTF-8 string blob, every track carries a lowercased search key. The keys
+ * are loaded into a fuzzy matcher once the file is opened, so searches tolerate typos.
+ * Tracks are grouped by the library source they came from, e.g. a playlist, along with a
+ * fingerprint of the source, so unchanged sources can be kept on the next sync.
+ */
+class LibraryIndex
+{
+public:
+    /**
+     * Tracks of one library source, e.g. saved tracks or a single playlist.
+     */
+    struct Source
+    {
+        QString key;          // Identifies the source across syncs
+        QString fingerprint;  // Changes whenever the content of the source changes
+        QVector<Track> tracks;
+    };
+
+    /**
+     * Set path of the index file and open it, if it exists.
+     * @param path Path to the index file.
+     */
+    void setPath(const QString& path);
+
+    /**
+     * Returns true if there are no indexed tracks.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns number of indexed tracks, duplicates across sources included.
+     */
+    qsizetype size() const;
+
+    /**
+     * Find tracks matching all words of the query in their name, artists or album.
+     * @param query The search query, words may be misspelled.
+     * @param limit The maximum number of tracks to return.
+     * @return Distinct matching tracks, best first, equally good in the order of the sources.
+     */
+    QVector<Track> search(const QString& query, qsizetype limit) const;
+
+    /**
+     * Returns all sources of the index in their order.
+     */
+    QList<Source> sources() const;
+
+    /**
+     * Replace the index by the given sources.
+     * The file is replaced atomically, concurrent searches see either version.
+     * @param sources Sources in the order their tracks should be ranked.
+     * @return true if the index was written.
+     */
+    bool write(const QList<Source>& sources);
+
+private:
+    struct StringRef;
+    struct Header;
+    struct SourceRecord;
+    struct TrackRecord;
+
+    mutable QReadWriteLock lock;
+    QString path;
+    std::unique_ptr<QFile> file;
+
+    // Parts of the mapped file, the header is null if no valid file is mapped.
+    const Header* header = nullptr;
+    const SourceRecord* sourceRecords = nullptr;
+    const TrackRecord* trackRecords = nullptr;
+    const char* strings = nullptr;
+
+    FuzzyMatcher matcher;
+    QVector<quint32> matcherTracks;  // Track record of each key of the matcher
+
+    /**
+     * Map the index file and fill the matcher, the previous mapping is dropped. Expects the write lock.
+     */
+    void open();
+
+    /**
+     * Returns a string of the blob as a view without copying.
+     */
+    std::string_view view(const StringRef& ref) const;
+
+    /**
+     * Returns a string of the blob as an owned string.
+     */
+    QString string(const StringRef& ref) const;
+
+    /**
+     * Decode a track record.
+     */
+    Track track(const TrackRecord& record) const;
+};
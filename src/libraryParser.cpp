@@ -0,0 +1,239 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "libraryParser.h"
+using namespace std;
+
+
+LibraryParser::LibraryParser(const QByteArrayView json):
+    SearchParser(json)
+{
+}
+
+optional<LibraryPage> LibraryParser::parseTrackItems(const QByteArrayView json)
+{
+    LibraryParser parser(json);
+    auto& reader = parser.reader;
+
+    if (!reader.enterObject())
+        return nullopt;
+
+    parser.readPage([&]
+    {
+        string_view key;
+
+        if (!reader.enterObject())
+            return;
+
+        while (reader.nextMember(key))
+        {
+            if (key == "track")
+                parser.appendTrack();
+            else
+                reader.skip();
+        }
+    }, &parser.page);
+
+    return parser.result();
+}
+
+optional<LibraryPage> LibraryParser::parseAlbumItems(const QByteArrayView json)
+{
+    LibraryParser parser(json);
+    auto& reader = parser.reader;
+
+    if (!reader.enterObject())
+        return nullopt;
+
+    parser.readPage([&]
+    {
+        string_view key;
+
+        if (!reader.enterObject())
+            return;
+
+        while (reader.nextMember(key))
+        {
+            if (key == "album")
+                parser.readSavedAlbum();
+            else
+                reader.skip();
+        }
+    }, &parser.page);
+
+    return parser.result();
+}
+
+optional<LibraryPage> LibraryParser::parsePlaylists(const QByteArrayView json)
+{
+    LibraryParser parser(json);
+    auto& reader = parser.reader;
+
+    if (!reader.enterObject())
+        return nullopt;
+
+    parser.readPage([&]
+    {
+        QString id, snapshot;
+        string_view key;
+
+        if (!reader.enterObject())
+            return;
+
+        while (reader.nextMember(key))
+        {
+            if (key == "id")
+                id = reader.readString();
+            else if (key == "snapshot_id")
+                snapshot = reader.readString();
+            else
+                reader.skip();
+        }
+
+        if (id.isEmpty())
+            return;
+
+        parser.page.ids.append(id);
+        parser.page.snapshots.append(snapshot);
+    }, &parser.page);
+
+    return parser.result();
+}
+
+optional<LibraryPage> LibraryParser::parseArtists(const QByteArrayView json)
+{
+    LibraryParser parser(json);
+    auto& reader = parser.reader;
+    string_view key;
+
+    if (!reader.enterObject())
+        return nullopt;
+
+    // Followed artists are wrapped in an object holding the paging object.
+    while (reader.nextMember(key))
+    {
+        if (key != "artists")
+        {
+            reader.skip();
+            continue;
+        }
+
+        if (!reader.enterObject())
+            continue;
+
+        parser.readPage([&]
+        {
+            if (!reader.enterObject())
+                return;
+
+            while (reader.nextMember(key))
+            {
+                if (key == "id")
+                    parser.page.ids.append(reader.readString());
+                else
+                    reader.skip();
+            }
+        }, &parser.page);
+    }
+
+    return parser.result();
+}
+
+optional<LibraryPage> LibraryParser::parseTopTracks(const QByteArrayView json)
+{
+    LibraryParser parser(json);
+    auto& reader = parser.reader;
+    string_view key;
+
+    if (!reader.enterObject())
+        return nullopt;
+
+    while (reader.nextMember(key))
+    {
+        if (key != "tracks")
+        {
+            reader.skip();
+            continue;
+        }
+
+        if (!reader.enterArray())
+            continue;
+
+        while (reader.nextElement())
+            parser.appendTrack();
+    }
+
+    return parser.result();
+}
+
+optional<LibraryPage> LibraryParser::result()
+{
+    if (reader.hasError())
+        return nullopt;
+
+    return std::move(page);
+}
+
+void LibraryParser::readPage(const function<void()>& readItem, LibraryPage* paging)
+{
+    // Expects the paging object to be entered already.
+    string_view key;
+
+    while (reader.nextMember(key))
+    {
+        if (key == "items")
+        {
+            if (!reader.enterArray())
+                continue;
+
+            while (reader.nextElement())
+                readItem();
+        }
+        else if (key == "next" && paging)
+            paging->next = reader.readString();
+        else if (key == "total" && paging)
+            paging->total = reader.readInteger();
+        else
+            reader.skip();
+    }
+}
+
+void LibraryParser::readSavedAlbum()
+{
+    // Tracks of an album do not repeat the album, it is filled in once the album is read.
+    auto album = Track();
+    const auto firstTrack = page.tracks.size();
+    string_view key;
+
+    if (!reader.enterObject())
+        return;
+
+    while (reader.nextMember(key))
+    {
+        if (key == "id")
+            album.albumId = readInterned();
+        else if (key == "name")
+            album.albumName = readInterned();
+        else if (key == "images")
+            album.imageUrl = readImage();
+        else if (key == "tracks" && reader.enterObject())
+            readPage([this] { appendTrack(); }, nullptr);
+        else if (key != "tracks")
+            reader.skip();
+    }
+
+    for (auto i = firstTrack; i < page.tracks.size(); ++i)
+    {
+        auto& track = page.tracks[i];
+        track.albumId = album.albumId;
+        track.albumName = album.albumName;
+        track.imageUrl = album.imageUrl;
+    }
+}
+
+void LibraryParser::appendTrack()
+{
+    auto track = readTrack();
+
+    if (!track.id.isEmpty() && track.uri.startsWith(QLatin1String("spotify:track:")))
+        page.tracks.append(std::move(track));
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include "searchParser.h"
+#include <QStringList>
+#include <functional>
+#include <optional>
+
+
+/**
+ * One page of a Web API listing of the users library.
+ */
+struct LibraryPage
+{
+    QVector<Track> tracks;
+    QStringList ids;        // IDs of listed playlists or artists
+    QStringList snapshots;  // Snapshot IDs of listed playlists, parallel to ids
+    QString next;           // URL of the next page, empty on the last one
+    qint64 total = 0;
+};
+
+
+/**
+ * Parser of Web API responses listing the users library, e.g. saved tracks or playlists.
+ * Tracks are read the same way as search results and share their interned strings.
+ */
+class LibraryParser : private SearchParser
+{
+public:
+    /**
+     * Parse a page of saved tracks or playlist items, both wrap tracks in item objects.
+     * Episodes and local files are left out.
+     * @return The page or nothing if the response is malformed.
+     */
+    static std::optional<LibraryPage> parseTrackItems(QByteArrayView json);
+
+    /**
+     * Parse a page of saved albums to the tracks of the albums.
+     */
+    static std::optional<LibraryPage> parseAlbumItems(QByteArrayView json);
+
+    /**
+     * Parse a page of playlists to their IDs and snapshot IDs.
+     */
+    static std::optional<LibraryPage> parsePlaylists(QByteArrayView json);
+
+    /**
+     * Parse a page of followed artists to their IDs.
+     */
+    static std::optional<LibraryPage> parseArtists(QByteArrayView json);
+
+    /**
+     * Parse top tracks of an artist.
+     */
+    static std::optional<LibraryPage> parseTopTracks(QByteArrayView json);
+
+private:
+    explicit LibraryParser(QByteArrayView json);
+
+    LibraryPage page;
+
+    /**
+     * Returns the parsed page or nothing if the input was malformed.
+     */
+    std::optional<LibraryPage> result();
+
+    /**
+     * Parse the paging object at the current position.
+     * @param readItem Called at every item of the page to consume it.
+     * @param paging Receives the next page URL and total, nothing for nested pages.
+     */
+    void readPage(const std::function<void()>& readItem, LibraryPage* paging);
+
+    /**
+     * Parse the saved album object at the current position and append its tracks.
+     */
+    void readSavedAlbum();
+
+    /**
+     * Parse the track object at the current position and append it if it is a track.
+     */
+    void appendTrack();
+};
@@ -0,0 +1,242 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "librarySync.h"
+#include "spotifyApiClient.h"
+#include <albert/logging.h>
+Q_DECLARE_LOGGING_CATEGORY(AlbertLoggingCategory)
+using namespace std;
+
+inline int LIBRARY_SYNC_INTERVAL = 3600000;
+inline QString SAVED_TRACKS_URL = "/v1/me/tracks?limit=%1";
+inline QString SAVED_ALBUMS_URL = "/v1/me/albums?limit=%1";
+inline QString PLAYLISTS_URL = "/v1/me/playlists?limit=50";
+inline QString PLAYLIST_TRACKS_URL = "/v1/playlists/%1/tracks?limit=100"
+                                     "&fields=next,total,items(track(id,name,uri,explicit,artists(name),album(id,name,images)))";
+inline QString FOLLOWED_ARTISTS_URL = "/v1/me/following?type=artist&limit=50";
+inline QString TOP_TRACKS_URL = "/v1/artists/%1/top-tracks?market=from_token";
+inline int PAGE_SIZE = 50;
+
+
+LibrarySync::LibrarySync(SpotifyApiClient& api, LibraryIndex& index):
+    api(api),
+    index(index)
+{
+    timer.setInterval(LIBRARY_SYNC_INTERVAL);
+    connect(&timer, &QTimer::timeout, this, &LibrarySync::sync);
+}
+
+bool LibrarySync::isEnabled() const { return timer.isActive(); }
+
+void LibrarySync::setEnabled(const bool enabled)
+{
+    if (enabled == isEnabled())
+        return;
+
+    if (enabled)
+    {
+        timer.start();
+        sync();
+    }
+    else
+        timer.stop();
+}
+
+void LibrarySync::sync()
+{
+    if (running)
+        return;
+
+    running = true;
+    previous.clear();
+    synced.clear();
+
+    for (auto& source : index.sources())
+        previous.insert(source.key, std::move(source));
+
+    // Sources are synced in the order their tracks rank in search results.
+    steps = {
+        [this] { syncSaved("tracks", SAVED_TRACKS_URL, LibraryParser::parseTrackItems); },
+        [this] { syncSaved("albums", SAVED_ALBUMS_URL, LibraryParser::parseAlbumItems); },
+        [this] { syncPlaylists(); },
+        [this] { syncArtists(); }
+    };
+
+    nextStep();
+}
+
+void LibrarySync::nextStep()
+{
+    if (!running)
+        return;
+
+    if (!steps.isEmpty())
+    {
+        steps.takeFirst()();
+        return;
+    }
+
+    running = false;
+    previous.clear();
+
+    if (index.write(synced))
+        INFO << QString("Library index synced, %1 tracks.").arg(index.size());
+    else
+        WARN << "Failed to write the library index.";
+
+    synced.clear();
+}
+
+void LibrarySync::abort()
+{
+    WARN << "Library sync failed, keeping the previous index.";
+
+    running = false;
+    steps.clear();
+    previous.clear();
+    synced.clear();
+}
+
+void LibrarySync::syncSource(const QString& key, const QString& fingerprint,
+                             const function<void(function<void(optional<QVector<Track>>)>)>& fetch)
+{
+    if (const auto it = previous.constFind(key); it != previous.cend() && it->fingerprint == fingerprint)
+    {
+        synced.append(*it);
+        nextStep();
+        return;
+    }
+
+    fetch([this, key, fingerprint](optional<QVector<Track>> tracks)
+    {
+        // A failed source keeps its previous tracks and fingerprint, so the next sync retries it.
+        if (tracks)
+            synced.append(LibraryIndex::Source{.key = key, .fingerprint = fingerprint, .tracks = std::move(*tracks)});
+        else if (const auto it = previous.constFind(key); it != previous.cend())
+        {
+            WARN << "Failed to sync library source" << key << ", keeping its previous tracks.";
+            synced.append(*it);
+        }
+        else
+            WARN << "Failed to sync library source" << key << ", skipping it.";
+
+        nextStep();
+    });
+}
+
+void LibrarySync::syncSaved(const QString& key, const QString& url, const Parser& parse)
+{
+    // The newest item and the total count change whenever items are saved or removed.
+    api.fetch(url.arg(1), [this, key, url, parse](const optional<QByteArray>& body)
+    {
+        const auto page = body ? parse(*body) : nullopt;
+
+        if (!page)
+        {
+            abort();
+            return;
+        }
+
+        const auto fingerprint = QString("%1|%2").arg(page->total).arg(page->tracks.value(0).id);
+
+        syncSource(key, fingerprint, [this, url, parse](const auto& done)
+        {
+            fetchPages(url.arg(PAGE_SIZE), parse, [done](optional<LibraryPage> all)
+            {
+                done(all ? optional(std::move(all->tracks)) : nullopt);
+            });
+        });
+    });
+}
+
+void LibrarySync::syncPlaylists()
+{
+    fetchPages(PLAYLISTS_URL, LibraryParser::parsePlaylists, [this](const optional<LibraryPage>& playlists)
+    {
+        if (!playlists)
+        {
+            abort();
+            return;
+        }
+
+        QList<function<void()>> playlistSteps;
+
+        for (qsizetype i = 0; i < playlists->ids.size(); ++i)
+        {
+            const auto id = playlists->ids.at(i);
+            const auto snapshot = playlists->snapshots.value(i);
+
+            playlistSteps.append([this, id, snapshot]
+            {
+                syncSource("playlist:" + id, snapshot, [this, id](const auto& done)
+                {
+                    fetchPages(PLAYLIST_TRACKS_URL.arg(id), LibraryParser::parseTrackItems,
+                               [done](optional<LibraryPage> all)
+                    {
+                        done(all ? optional(std::move(all->tracks)) : nullopt);
+                    });
+                });
+            });
+        }
+
+        steps = playlistSteps + steps;
+        nextStep();
+    });
+}
+
+void LibrarySync::syncArtists()
+{
+    fetchPages(FOLLOWED_ARTISTS_URL, LibraryParser::parseArtists, [this](const optional<LibraryPage>& artists)
+    {
+        if (!artists)
+        {
+            abort();
+            return;
+        }
+
+        QList<function<void()>> artistSteps;
+
+        // Top tracks barely change, so an artist is fetched only once followed.
+        for (const auto& id : artists->ids)
+        {
+            artistSteps.append([this, id]
+            {
+                syncSource("artist:" + id, {}, [this, id](const auto& done)
+                {
+                    api.fetch(TOP_TRACKS_URL.arg(id), [done](const optional<QByteArray>& body)
+                    {
+                        const auto page = body ? LibraryParser::parseTopTracks(*body) : nullopt;
+                        done(page ? optional(page->tracks) : nullopt);
+                    });
+                });
+            });
+        }
+
+        steps = artistSteps + steps;
+        nextStep();
+    });
+}
+
+void LibrarySync::fetchPages(const QString& url, const Parser& parse,
+                             const function<void(optional<LibraryPage>)>& done, LibraryPage collected)
+{
+    api.fetch(url, [this, parse, done, collected](const optional<QByteArray>& body) mutable
+    {
+        const auto page = body ? parse(*body) : nullopt;
+
+        if (!page)
+        {
+            done(nullopt);
+            return;
+        }
+
+        collected.tracks.append(page->tracks);
+        collected.ids.append(page->ids);
+        collected.snapshots.append(page->snapshots);
+        collected.total = max(collected.total, page->total);
+
+        if (page->next.isEmpty())
+            done(std::move(collected));
+        else
+            fetchPages(page->next, parse, done, std::move(collected));
+    });
+}
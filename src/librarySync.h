@@ -0,0 +1,101 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include "libraryIndex.h"
+#include "libraryParser.h"
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+#include <functional>
+#include <optional>
+class SpotifyApiClient;
+
+
+/**
+ * Keeps the local library index in sync with the users library in the background.
+ *
+ * Saved tracks, saved albums, playlists and top tracks of followed artists are synced
+ * source by source on the thread of the client. Unchanged sources are taken over from
+ * the previous index: saved tracks and albums are compared by their count and most
+ * recent item, playlists by their snapshot ID, and artists are fetched only once
+ * they are followed. A sync of an unchanged library thus costs a few small requests.
+ */
+class LibrarySync final : public QObject
+{
+public:
+    LibrarySync(SpotifyApiClient& api, LibraryIndex& index);
+
+    bool isEnabled() const;
+
+    /**
+     * Enable periodic syncs, the first one starts right away.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Start a sync unless one is running already.
+     */
+    void sync();
+
+private:
+    Q_OBJECT
+
+    using Parser = std::function<std::optional<LibraryPage>(QByteArrayView)>;
+
+    SpotifyApiClient& api;
+    LibraryIndex& index;
+    QTimer timer;
+    bool running = false;
+
+    QHash<QString, LibraryIndex::Source> previous;  // Sources of the index when the sync started
+    QList<LibraryIndex::Source> synced;
+    QList<std::function<void()>> steps;
+
+    /**
+     * Run the next step of the sync or finish it once there are no more steps.
+     */
+    void nextStep();
+
+    /**
+     * Abort the sync and keep the index as it is, used if a top-level listing fails.
+     */
+    void abort();
+
+    /**
+     * Take over a source from the previous index or sync it using the given function.
+     * If the fetch fails, the source keeps its previous tracks, if any, and the sync goes on.
+     * @param key The key of the source.
+     * @param fingerprint Current fingerprint of the source.
+     * @param fetch Fetches tracks of the source if it changed, std::nullopt on failure.
+     */
+    void syncSource(const QString& key, const QString& fingerprint,
+                    const std::function<void(std::function<void(std::optional<QVector<Track>>)>)>& fetch);
+
+    /**
+     * Sync saved items whose fingerprint is taken from the first page.
+     * @param key The key of the source.
+     * @param url URL of the saved items.
+     * @param parse Parser of the pages.
+     */
+    void syncSaved(const QString& key, const QString& url, const Parser& parse);
+
+    /**
+     * Sync all playlists of the user.
+     */
+    void syncPlaylists();
+
+    /**
+     * Sync top tracks of all followed artists.
+     */
+    void syncArtists();
+
+    /**
+     * Fetch all pages of a listing and merge them.
+     * @param url URL of the first page.
+     * @param parse Parser of the pages.
+     * @param done Called with all pages merged, std::nullopt if any request fails.
+     * @param collected Pages fetched so far.
+     */
+    void fetchPages(const QString& url, const Parser& parse,
+                    const std::function<void(std::optional<LibraryPage>)>& done, LibraryPage collected = {});
+};
@@ -0,0 +1,126 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <optional>
+
+/**
+ * Thread-safe bounded cache evicting the least recently used entries.
+ * Entries older than the time to live are treated as missing.
+ */
+template<typename Key, typename Value>
+class LruCache
+{
+public:
+    /**
+     * @param capacity Maximum number of entries, zero disables the cache.
+     * @param timeToLive Maximum age of an entry in milliseconds.
+     */
+    LruCache(const qsizetype capacity, const qint64 timeToLive):
+        capacity_(capacity),
+        timeToLive_(timeToLive)
+    {
+    }
+
+    /**
+     * Look up an entry and mark it as the most recently used one.
+     * @param key The key to look up.
+     * @return The cached value or nothing if it is missing or expired.
+     */
+    std::optional<Value> get(const Key& key)
+    {
+        QMutexLocker locker(&mutex);
+
+        const auto it = index.find(key);
+        if (it == index.end())
+        {
+            ++misses_;
+            return std::nullopt;
+        }
+
+        if (QDateTime::currentMSecsSinceEpoch() - it.value()->timestamp > timeToLive_)
+        {
+            entries.erase(it.value());
+            index.erase(it);
+            ++misses_;
+            return std::nullopt;
+        }
+
+        entries.splice(entries.begin(), entries, it.value());
+        ++hits_;
+        return entries.front().value;
+    }
+
+    /**
+     * Insert or replace an entry, evicting the least recently used ones if full.
+     * @param key The key of the entry.
+     * @param value The value to store.
+     */
+    void put(const Key& key, Value value)
+    {
+        QMutexLocker locker(&mutex);
+
+        if (const auto it = index.find(key); it != index.end())
+        {
+            entries.erase(it.value());
+            index.erase(it);
+        }
+
+        if (capacity_ <= 0)
+            return;
+
+        entries.push_front({key, std::move(value), QDateTime::currentMSecsSinceEpoch()});
+        index.insert(key, entries.begin());
+
+        evict();
+    }
+
+    void setCapacity(const qsizetype capacity)
+    {
+        QMutexLocker locker(&mutex);
+        capacity_ = capacity;
+        evict();
+    }
+
+    void setTimeToLive(const qint64 timeToLive)
+    {
+        QMutexLocker locker(&mutex);
+        timeToLive_ = timeToLive;
+    }
+
+    /** Returns number of successful lookups. */
+    quint64 hits() const { return hits_; }
+
+    /** Returns number of lookups of missing or expired entries. */
+    quint64 misses() const { return misses_; }
+
+private:
+    struct Entry
+    {
+        Key key;
+        Value value;
+        qint64 timestamp;
+    };
+
+    QMutex mutex;
+    std::list<Entry> entries;  // Most recently used first
+    QHash<Key, typename std::list<Entry>::iterator> index;
+    qsizetype capacity_;
+    qint64 timeToLive_;
+    std::atomic<quint64> hits_ = 0;
+    std::atomic<quint64> misses_ = 0;
+
+    void evict()
+    {
+        while (entries.size() > static_cast<size_t>(std::max<qsizetype>(capacity_, 0)))
+        {
+            index.remove(entries.back().key);
+            entries.pop_back();
+        }
+    }
+};
@@ -0,0 +1,112 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "metrics.h"
+#include <QStringList>
+#include <algorithm>
+#include <albert/logging.h>
+Q_DECLARE_LOGGING_CATEGORY(AlbertLoggingCategory)
+using namespace std;
+
+
+Metrics::StageTimer::StageTimer(Metrics& m, const char* s):
+    metrics(m),
+    stage(s)
+{
+    if (metrics.isEnabled())
+        timer.start();
+}
+
+Metrics::StageTimer::~StageTimer()
+{
+    if (!timer.isValid())
+        return;
+
+    const auto msecs = timer.elapsed();
+    metrics.recordStage(stage, msecs);
+    DEBG << QString("Stage %1 took %2 ms").arg(stage).arg(msecs);
+}
+
+bool Metrics::isEnabled() const { return enabled; }
+
+void Metrics::setEnabled(const bool v) { enabled = v; }
+
+void Metrics::recordRequest(const QString& endpoint, const qint64 bytes, const qint64 msecs)
+{
+    if (!enabled)
+        return;
+
+    QMutexLocker locker(&mutex);
+    auto& series = requests[endpoint];
+    series.add(msecs);
+    series.bytes += bytes;
+}
+
+void Metrics::recordStage(const QString& stage, const qint64 msecs)
+{
+    if (!enabled)
+        return;
+
+    QMutexLocker locker(&mutex);
+    stages[stage].add(msecs);
+}
+
+void Metrics::increment(const QString& counter, const quint64 value)
+{
+    if (!enabled)
+        return;
+
+    QMutexLocker locker(&mutex);
+    counters[counter] += value;
+}
+
+QString Metrics::summary() const
+{
+    QMutexLocker locker(&mutex);
+    QStringList lines;
+
+    const auto describe = [](const QString& name, const Series& series)
+    {
+        return QString("%1: %2× avg %3 ms, p50 ≤%4 ms, p95 ≤%5 ms")
+            .arg(name)
+            .arg(series.count)
+            .arg(series.count ? series.totalMsecs / static_cast<qint64>(series.count) : 0)
+            .arg(series.percentile(0.5))
+            .arg(series.percentile(0.95));
+    };
+
+    lines << "Requests";
+    for (auto it = requests.cbegin(); it != requests.cend(); ++it)
+        lines << QString("  %1, %2 kB").arg(describe(it.key(), it.value())).arg(it.value().bytes / 1024);
+
+    lines << "Stages";
+    for (auto it = stages.cbegin(); it != stages.cend(); ++it)
+        lines << "  " + describe(it.key(), it.value());
+
+    lines << "Counters";
+    for (auto it = counters.cbegin(); it != counters.cend(); ++it)
+        lines << QString("  %1: %2").arg(it.key()).arg(it.value());
+
+    return lines.join('\n');
+}
+
+void Metrics::Series::add(const qint64 msecs)
+{
+    ++count;
+    totalMsecs += msecs;
+    maxMsecs = max(maxMsecs, msecs);
+
+    const auto bucket = ranges::lower_bound(BUCKET_BOUNDS, msecs) - BUCKET_BOUNDS.begin();
+    ++histogram[bucket];
+}
+
+qint64 Metrics::Series::percentile(const double p) const
+{
+    quint64 seen = 0;
+    for (size_t i = 0; i < histogram.size(); ++i)
+    {
+        seen += histogram[i];
+        if (count && static_cast<double>(seen) >= p * static_cast<double>(count))
+            return i < BUCKET_BOUNDS.size() ? min(BUCKET_BOUNDS[i], maxMsecs) : maxMsecs;
+    }
+    return 0;
+}
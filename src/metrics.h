@@ -0,0 +1,102 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <array>
+#include <atomic>
+
+
+/**
+ * Lightweight statistics of requests, query stages and counters.
+ * Recording is a cheap no-op while the collection is disabled.
+ */
+class Metrics
+{
+public:
+    /**
+     * Measures duration of a stage from construction to destruction.
+     */
+    class StageTimer
+    {
+    public:
+        StageTimer(Metrics& metrics, const char* stage);
+        ~StageTimer();
+
+    private:
+        Metrics& metrics;
+        const char* stage;
+        QElapsedTimer timer;
+    };
+
+    /**
+     * Run a function and record its duration as a stage.
+     * @param stage Name of the stage.
+     * @param function The function to run.
+     * @return The result of the function.
+     */
+    template<typename Function>
+    auto measure(const char* stage, Function&& function)
+    {
+        StageTimer timer(*this, stage);
+        return function();
+    }
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    /**
+     * Record a finished request.
+     * @param endpoint Name of the endpoint class, e.g. the URL path.
+     * @param bytes Size of the response body.
+     * @param msecs Time from sending the request until it finished.
+     */
+    void recordRequest(const QString& endpoint, qint64 bytes, qint64 msecs);
+
+    /**
+     * Record duration of a stage.
+     * @param stage Name of the stage.
+     * @param msecs Duration of the stage.
+     */
+    void recordStage(const QString& stage, qint64 msecs);
+
+    /**
+     * Increment a named counter.
+     * @param counter Name of the counter.
+     * @param value Value to add.
+     */
+    void increment(const QString& counter, quint64 value = 1);
+
+    /**
+     * Returns human-readable summary of everything recorded.
+     */
+    QString summary() const;
+
+private:
+    // Upper bounds of latency histogram buckets in milliseconds, the last bucket is unbounded.
+    static constexpr std::array<qint64, 9> BUCKET_BOUNDS = {10, 25, 50, 100, 250, 500, 1000, 2500, 5000};
+
+    struct Series
+    {
+        quint64 count = 0;
+        qint64 bytes = 0;
+        qint64 totalMsecs = 0;
+        qint64 maxMsecs = 0;
+        std::array<quint64, BUCKET_BOUNDS.size() + 1> histogram = {};
+
+        void add(qint64 msecs);
+
+        /**
+         * Returns upper bound of the percentile, the largest sample if it is in the unbounded bucket.
+         */
+        qint64 percentile(double p) const;
+    };
+
+    std::atomic<bool> enabled = false;
+    mutable QMutex mutex;
+    QMap<QString, Series> requests;
+    QMap<QString, Series> stages;
+    QMap<QString, quint64> counters;
+};
@@ -0,0 +1,139 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "playHistory.h"
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <albert/logging.h>
+#include <algorithm>
+#include <cmath>
+Q_DECLARE_LOGGING_CATEGORY(AlbertLoggingCategory)
+using namespace std;
+
+inline double HISTORY_HALF_LIFE = 14.0 * 24 * 3600 * 1000;  // Milliseconds after which a use counts half
+inline qsizetype HISTORY_SIZE = 500;
+
+
+void PlayHistory::setPath(const QString& path)
+{
+    QWriteLocker locker(&lock);
+
+    this->path = path;
+    entries.clear();
+
+    if (QFile file(path); file.open(QIODevice::ReadOnly))
+    {
+        for (const auto& value : QJsonDocument::fromJson(file.readAll()).object()["tracks"].toArray())
+        {
+            const auto object = value.toObject();
+
+            auto entry = Entry();
+            entry.track.id = object["id"].toString();
+            entry.track.name = object["name"].toString();
+            entry.track.artists = object["artists"].toString();
+            entry.track.albumId = object["album_id"].toString();
+            entry.track.albumName = object["album_name"].toString();
+            entry.track.uri = object["uri"].toString();
+            entry.track.imageUrl = object["image_url"].toString();
+            entry.track.isExplicit = object["explicit"].toBool();
+            entry.score = object["score"].toDouble();
+            entry.lastUsed = object["last_used"].toInteger();
+
+            if (!entry.track.id.isEmpty())
+                entries.append(std::move(entry));
+        }
+    }
+
+    const auto now = QDateTime::currentMSecsSinceEpoch();
+    ranges::stable_sort(entries, greater<>(), [now](const Entry& e) { return frecency(e, now); });
+
+    rebuildMatcher();
+}
+
+void PlayHistory::record(const Track& track)
+{
+    QWriteLocker locker(&lock);
+
+    const auto now = QDateTime::currentMSecsSinceEpoch();
+
+    auto entry = Entry{.track = track, .score = 1.0, .lastUsed = now};
+
+    if (const auto it = ranges::find(entries, track.id, [](const Entry& e) { return e.track.id; });
+        it != entries.end())
+    {
+        entry.score += frecency(*it, now);
+        entries.erase(it);
+    }
+
+    // Scores of the other entries decay equally, so the entry just moves up to its place.
+    const auto position = ranges::find_if(entries, [&](const Entry& e) { return frecency(e, now) < entry.score; });
+    entries.insert(position, std::move(entry));
+
+    if (entries.size() > HISTORY_SIZE)
+        entries.resize(HISTORY_SIZE);
+
+    rebuildMatcher();
+
+    if (!save())
+        WARN << "Failed to save the play history:" << path;
+}
+
+QVector<Track> PlayHistory::search(const QString& query, const qsizetype limit) const
+{
+    QReadLocker locker(&lock);
+
+    QVector<Track> tracks;
+    for (const auto index : matcher.match(query, limit))
+        tracks.append(entries[index].track);
+
+    return tracks;
+}
+
+double PlayHistory::frecency(const Entry& entry, const qint64 now)
+{
+    return entry.score * exp2(-static_cast<double>(now - entry.lastUsed) / HISTORY_HALF_LIFE);
+}
+
+void PlayHistory::rebuildMatcher()
+{
+    matcher.clear();
+
+    for (const auto& entry : entries)
+    {
+        const auto key = QString("%1 %2 %3")
+                             .arg(entry.track.name, entry.track.artists, entry.track.albumName)
+                             .toLower().toUtf8();
+        matcher.append(string_view(key.constData(), key.size()));
+    }
+}
+
+bool PlayHistory::save() const
+{
+    if (path.isEmpty())
+        return false;
+
+    QJsonArray tracks;
+    for (const auto& entry : entries)
+        tracks.append(QJsonObject{
+            {"id", entry.track.id},
+            {"name", entry.track.name},
+            {"artists", entry.track.artists},
+            {"album_id", entry.track.albumId},
+            {"album_name", entry.track.albumName},
+            {"uri", entry.track.uri},
+            {"image_url", entry.track.imageUrl},
+            {"explicit", entry.track.isExplicit},
+            {"score", entry.score},
+            {"last_used", entry.lastUsed}
+        });
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(QJsonDocument(QJsonObject{{"tracks", tracks}}).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
@@ -0,0 +1,69 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include "fuzzyMatcher.h"
+#include "types/track.h"
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+
+
+/**
+ * Persistent history of tracks the user played or queued, ranked by frecency.
+ *
+ * Every use adds one to the score of a track, scores decay exponentially with time, so
+ * tracks used often and recently rank first. Since all scores decay at the same rate,
+ * their order only changes when a track is used, the tracks are kept sorted and matched
+ * by a fuzzy matcher which ranks equally good matches by frecency.
+ */
+class PlayHistory
+{
+public:
+    /**
+     * Set path of the history file and load it, if it exists.
+     * @param path Path to the history file.
+     */
+    void setPath(const QString& path);
+
+    /**
+     * Record a use of the track and save the history.
+     * @param track The played or queued track.
+     */
+    void record(const Track& track);
+
+    /**
+     * Find tracks matching all words of the query.
+     * @param query The search query, words may be misspelled.
+     * @param limit The maximum number of tracks to return.
+     * @return Matching tracks, best matches first, equally good ones by frecency.
+     */
+    QVector<Track> search(const QString& query, qsizetype limit) const;
+
+private:
+    struct Entry
+    {
+        Track track;
+        double score;     // Frecency at the time of the last use
+        qint64 lastUsed;  // Milliseconds since epoch
+    };
+
+    mutable QReadWriteLock lock;
+    QString path;
+    QVector<Entry> entries;  // Highest frecency first
+    FuzzyMatcher matcher;    // Keys of the entries in their order
+
+    /**
+     * Returns frecency of the entry at the given time.
+     */
+    static double frecency(const Entry& entry, qint64 now);
+
+    /**
+     * Fill the matcher with the entries. Expects the write lock.
+     */
+    void rebuildMatcher();
+
+    /**
+     * Write the entries to the history file. Expects a lock.
+     */
+    bool save() const;
+};
@@ -1,10 +1,18 @@
 // Copyright (c) 2020-2025 Ivo Šmerek
 
+#include "coverStore.h"
+#include "libraryIndex.h"
+#include "librarySync.h"
+#include "playHistory.h"
 #include "plugin.h"
+#include "prefetcher.h"
+#include "remoteSearch.h"
+#include "resultItems.h"
 #include "spotifyApiClient.h"
 #include "ui_configwidget.h"
 #include <QDir>
 #include <QMessageBox>
+#include <QSet>
 #include <QSettings>
 #include <QThread>
 #include <albert/albert.h>
@@ -24,8 +32,32 @@ inline auto CFG_NUM_RESULTS = "number_of_results";
 inline auto DEF_NUM_RESULTS = 5;
 inline auto CFG_SPOTIFY_EXECUTABLE = "spotify_executable";
 inline auto DEF_SPOTIFY_EXECUTABLE = "spotify";
+inline auto CFG_PARALLEL_DOWNLOADS = "parallel_downloads";
+inline auto DEF_PARALLEL_DOWNLOADS = 6;
+inline auto CFG_SEARCH_CACHE_SIZE = "search_cache_size";
+inline auto DEF_SEARCH_CACHE_SIZE = 100;
+inline auto CFG_SEARCH_CACHE_TTL = "search_cache_ttl";
+inline auto DEF_SEARCH_CACHE_TTL = 300;
+inline auto CFG_COLLECT_STATISTICS = "collect_statistics";
+inline auto DEF_COLLECT_STATISTICS = false;
+inline auto CFG_COVER_CACHE_SIZE = "cover_cache_size";
+inline auto DEF_COVER_CACHE_SIZE = 100;  // MB
+inline auto CFG_LIBRARY_INDEX = "library_index";
+inline auto DEF_LIBRARY_INDEX = false;
+inline auto CFG_SEARCH_COLLECTIONS = "search_collections";
+inline auto DEF_SEARCH_COLLECTIONS = true;
+inline auto CFG_PREFETCH = "prefetch";
+inline auto DEF_PREFETCH = false;
 inline auto STATE_LAST_DEVICE = "last_device";
+inline auto STATE_ACCESS_TOKEN = "access_token";
+inline auto STATE_TOKEN_EXPIRATION = "access_token_expiration";
 inline auto COVERS_DIR_NAME = "covers";
+inline auto RESPONSES_DIR_NAME = "responses";
+inline auto LIBRARY_FILE_NAME = "library.idx";
+inline auto HISTORY_FILE_NAME = "history.json";
+inline qsizetype FIRST_PAGE_SIZE = 5;  // Small enough to be answered as fast as possible
+inline qsizetype MAX_PAGE_SIZE = 50;   // Limit of the Web API
+inline int MAX_SEARCH_PAGES = 5;
 
 
 Plugin::Plugin()
@@ -41,6 +73,86 @@ Plugin::Plugin()
     fetch_count_ = s->value(CFG_NUM_RESULTS).toUInt();
     show_explicit_content_ = s->value(CFG_ALLOW_EXPLICIT).toBool();
     spotify_command_ = s->value(CFG_SPOTIFY_EXECUTABLE).toString();
+    parallel_downloads_ = s->value(CFG_PARALLEL_DOWNLOADS, DEF_PARALLEL_DOWNLOADS).toUInt();
+    search_cache_size_ = s->value(CFG_SEARCH_CACHE_SIZE, DEF_SEARCH_CACHE_SIZE).toUInt();
+    search_cache_ttl_ = s->value(CFG_SEARCH_CACHE_TTL, DEF_SEARCH_CACHE_TTL).toUInt();
+    cover_cache_size_ = s->value(CFG_COVER_CACHE_SIZE, DEF_COVER_CACHE_SIZE).toUInt();
+    search_collections_ = s->value(CFG_SEARCH_COLLECTIONS, DEF_SEARCH_COLLECTIONS).toBool();
+    api->metrics().setEnabled(s->value(CFG_COLLECT_STATISTICS, DEF_COLLECT_STATISTICS).toBool());
+
+    api->setCacheDirectory(QString((cacheLocation() / RESPONSES_DIR_NAME).c_str()));
+    api->setSearchCacheSize(static_cast<int>(search_cache_size_));
+    api->setSearchCacheTimeToLive(static_cast<int>(search_cache_ttl_));
+    api->setMaxParallelDownloads(static_cast<int>(parallel_downloads_));
+
+    coverStore = make_unique<CoverStore>();
+    coverStore->setMaxSize(static_cast<qint64>(cover_cache_size_) * 1024 * 1024);
+    coverStore->setDirectory(QString((cacheLocation() / COVERS_DIR_NAME).c_str()));
+
+    connect(api.get(), &SpotifyApiClient::fileDownloaded, this,
+            [this](const QString& filePath, qint64 size) { coverStore->add(filePath, size); });
+
+    prefetcher = make_unique<Prefetcher>(*api, *coverStore);
+    prefetcher->setEnabled(s->value(CFG_PREFETCH, DEF_PREFETCH).toBool());
+
+    library = make_unique<LibraryIndex>();
+    library->setPath(QString((cacheLocation() / LIBRARY_FILE_NAME).c_str()));
+    librarySync = make_unique<LibrarySync>(*api, *library);
+
+    if (!is_directory(dataLocation()))
+        tryCreateDirectory(dataLocation());
+
+    history = make_unique<PlayHistory>();
+    history->setPath(QString((dataLocation() / HISTORY_FILE_NAME).c_str()));
+
+    // Reuse the access token of the previous session, so the first query does not wait for a refresh.
+    const auto st = state();
+    if (const auto expiration = st->value(STATE_TOKEN_EXPIRATION).toDateTime();
+        expiration > QDateTime::currentDateTime())
+        api->setAccessToken(st->value(STATE_ACCESS_TOKEN).toString(), expiration);
+
+    connect(api.get(), &SpotifyApiClient::accessTokenChanged, this,
+            [this](const QString& token, const QDateTime& expiration)
+    {
+        const auto st = state();
+        st->setValue(STATE_ACCESS_TOKEN, token);
+        st->setValue(STATE_TOKEN_EXPIRATION, expiration);
+    });
+
+    items = make_unique<ResultItems>(ResultItems::Handlers{
+        .play = [this](const Track& track)
+        {
+            history->record(track);
+            playOnPreferredDevice([this, &track](const QString& deviceId) { api->playTrack(track, deviceId); },
+                                  [this, &track] { api->waitForDeviceAndPlay(track); });
+        },
+        .playOn = [this](const Track& track, const QString& deviceId)
+        {
+            history->record(track);
+            api->playTrack(track, deviceId);
+            state()->setValue(STATE_LAST_DEVICE, deviceId);
+        },
+        .queue = [this](const Track& track)
+        {
+            history->record(track);
+            api->addTrackToQueue(track);
+        },
+        .playCollection = [this](const Collection& collection)
+        {
+            playOnPreferredDevice(
+                [this, &collection](const QString& deviceId) { api->playCollection(collection, deviceId); },
+                [this, &collection] { api->waitForDeviceAndPlay(collection); });
+        },
+        .playCollectionOn = [this](const Collection& collection, const QString& deviceId)
+        {
+            api->playCollection(collection, deviceId);
+            state()->setValue(STATE_LAST_DEVICE, deviceId);
+        }
+    });
+
+    api->startTokenRefresh();
+    api->warmUpConnections();
+    librarySync->setEnabled(s->value(CFG_LIBRARY_INDEX, DEF_LIBRARY_INDEX).toBool());
 }
 
 Plugin::~Plugin() = default;
@@ -49,128 +161,225 @@ QString Plugin::defaultTrigger() const { return "play "; }
 
 void Plugin::handleTriggerQuery(Query &query)
 {
+    // Typing the trigger alone already prepares connections for the upcoming search.
+    api->warmUpConnections();
+
     if (const auto trimmed = query.string().trimmed(); trimmed.isEmpty())
         return;
 
+    prefetcher->recordQuery(query.string());
+
     if (!query.isValid())
         return;
 
-    // If there is no internet connection, make one alerting item to let the user know.
-    if (!api->checkServerResponse())
+    // Every request issued on behalf of this query is aborted once the query is superseded.
+    const auto isValid = [&query] { return query.isValid(); };
+
+    auto& metrics = api->metrics();
+    const Metrics::StageTimer queryTimer(metrics, "query");
+
+    // Items are shown right away, covers missing in the store are collected while adding them
+    // and downloaded in the background afterwards. Until then items show a placeholder icon.
+    QHash<QString, QString> covers;
+
+    // IDs of results shown already, later sources only fill up the remaining results.
+    QSet<QString> shown;
+    const auto isFull = [&] { return shown.size() >= static_cast<qsizetype>(fetchCount()); };
+
+    const auto addTracks = [&](const shared_ptr<const QVector<Track>>& tracks, const QVector<Device>& devices)
+    {
+        for (const auto& track : *tracks)
+        {
+            if (isFull())
+                return;
+
+            // If the track is explicit and the user doesn't want to see explicit tracks, skip it.
+            if ((track.isExplicit && !showExplicitContent()) || shown.contains(track.id))
+                continue;
+
+            shown.insert(track.id);
+
+            // The store answers from its index without touching the disk, which also marks the cover as used.
+            if (!coverStore->contains(track.albumId))
+                covers.insert(coverStore->path(track.albumId), track.imageUrl);
+
+            // Aliasing pointer, it owns the whole result set and points to one track of it.
+            query.add(items->buildTrackItem(shared_ptr<const Track>(tracks, &track), devices,
+                                            coverStore->path(track.albumId)));
+        }
+    };
+
+    // Covers of collections are stored under their IDs, so an album shares its cover with its tracks.
+    const auto addCollections = [&](const shared_ptr<const QVector<Collection>>& collections,
+                                    const QVector<Device>& devices, const auto& filter)
+    {
+        for (const auto& collection : *collections)
+        {
+            if (isFull())
+                return;
+
+            if (!filter(collection) || shown.contains(collection.id))
+                continue;
+
+            shown.insert(collection.id);
+
+            if (!coverStore->contains(collection.id))
+                covers.insert(coverStore->path(collection.id), collection.imageUrl);
+
+            query.add(items->buildCollectionItem(shared_ptr<const Collection>(collections, &collection), devices,
+                                                 coverStore->path(collection.id)));
+        }
+    };
+
+    // Pages over-fetch if explicit tracks are filtered out, so they still fill up the results.
+    const auto pageSize = [&](const qsizetype wanted)
+    {
+        return static_cast<int>(clamp<qsizetype>(showExplicitContent() ? wanted : wanted * 2, 1, MAX_PAGE_SIZE));
+    };
+    const auto remaining = [&] { return static_cast<qsizetype>(fetchCount()) - shown.size(); };
+
+    // The first page is small, so its items are shown as soon as possible. It does not depend
+    // on the local results, so its cache entries can be prefetched.
+    const auto firstPageSize = pageSize(min(static_cast<qsizetype>(fetchCount()), FIRST_PAGE_SIZE));
+    RemoteSearch remote(*api, query.string(), firstPageSize, searchCollections());
+
+    // Tracks played before and tracks of the local library index need no request, so they
+    // are shown first, most frecent plays on top. Local items get device actions only if
+    // the devices were cached.
+    auto local = metrics.measure("history", [&] { return history->search(query.string(), fetchCount()); });
+
+    if (libraryIndexEnabled())
+        local += metrics.measure("library", [&] { return library->search(query.string(), fetchCount()); });
+
+    addTracks(make_shared<const QVector<Track>>(std::move(local)), remote.readyDevices());
+
+    // Replaying favourites is answered from local data alone.
+    if (isFull())
+    {
+        api->downloadFilesAsync(covers);
+        return;
+    }
+
+    auto [status, found, devices] = remote.run(isValid);
+
+    switch (status)
     {
+    case RemoteSearch::Status::Found:
+        break;
+
+    // If there is no internet connection, make one alerting item to let the user know.
+    case RemoteSearch::Status::Offline:
         DEBG << "No internet connection!";
         query.add(StandardItem::make(nullptr, "Can't get an answer from the server.",
                                       "Please, check your internet connection.", nullptr));
         return;
+
+    // Show why the server rejected the credentials, they are not retried until they change.
+    case RemoteSearch::Status::WrongCredentials:
+    {
+        const auto error = api->lastErrorMessage;
+        query.add(StandardItem::make(nullptr, "Wrong credentials.",
+                                      error.isEmpty() ? QString("Please, check the extension settings.")
+                                                      : QString("Spotify Web API returns: \"%1\"").arg(error),
+                                      nullptr));
+        return;
     }
 
-    // If the access token expires, try to refresh it or alert the user what is wrong.
-    if (api->isAccessTokenExpired())
+    // The server asked to slow down, tell the user instead of showing no results.
+    case RemoteSearch::Status::RateLimited:
     {
-        DEBG << "Token expired. Refreshing";
-        if (!api->refreshAccessToken())
-        {
-            query.add(StandardItem::make(nullptr, "Wrong credentials.",
-                                          "Please, check the extension settings.", nullptr));
-            return;
-        }
+        const auto seconds = (api->rateLimitedFor(SpotifyApiClient::Lane::Search) + 999) / 1000;
+        query.add(StandardItem::make(nullptr, "Spotify rate limit reached.",
+                                      QString("Searching again in %1 s.").arg(seconds), nullptr));
+        api->downloadFilesAsync(covers);
+        return;
     }
 
-    // Search for tracks on Spotify using the query.
-    const auto tracks = api->searchTracks(query.string(), fetchCount());
+    case RemoteSearch::Status::Cancelled:
+        return;
+    }
 
-    const auto coversCacheLocation = cacheLocation() / COVERS_DIR_NAME;
+    // The result set is a single immutable allocation, items and their actions share it
+    // instead of copying the tracks.
+    const auto results = make_shared<const SearchResults>(std::move(found));
+    const auto tracks = shared_ptr<const QVector<Track>>(results, &results->tracks);
+    const auto collections = shared_ptr<const QVector<Collection>>(results, &results->collections);
 
-    if (!is_directory(coversCacheLocation))
-        tryCreateDirectory(coversCacheLocation);
+    // Collections named like the query are what the user is looking for, so they come first,
+    // the others only fill up the results left after the tracks.
+    const auto prefix = query.string().simplified();
+    const auto isNamedLikeQuery = [&prefix](const Collection& c)
+    {
+        return c.name.startsWith(prefix, Qt::CaseInsensitive);
+    };
 
-    for (const auto& track : tracks)
     {
-        // If the track is explicit and the user doesn't want to see explicit tracks, skip it.
-        if (track.isExplicit && !showExplicitContent())
-            continue;
-
-        const auto filename = QString("%1/%2.jpeg").arg(coversCacheLocation.c_str(), track.albumId);
-
-        // Download cover image of the album.
-        api->downloadFile(track.imageUrl, filename);
-
-        // Create a standard item with a track name in title and album with artists in subtext.
-        const auto result = StandardItem::make(
-            track.id,
-            track.name,
-            QString("%1 (%2)").arg(track.albumName, track.artists),
-            nullptr,
-            {filename});
-
-        auto actions = vector<Action>();
-
-        actions.emplace_back(
-            "play",
-            "Play on Spotify",
-            [this, track]
-            {
-                // If we have no devices run local Spotify client
-                if (const auto devices = api->getDevices();
-                    devices.isEmpty())
-                {
-                    runDetachedProcess({spotify_command_});
-                    api->waitForDeviceAndPlay(track);
-                    INFO << "Playing on local Spotify.";
-                }
-
-                // If available, use an active device and play the track.
-                else if (auto it = ranges::find_if(devices, &Device::isActive);
-                    it != devices.cend())
-                {
-                    const auto activeDevice = *it;
-                    api->playTrack(track, it->id);
-                    INFO << "Playing on active device:" << it->name;
-                    state()->setValue(STATE_LAST_DEVICE, it->id);
-                }
-
-                // If available, use the last-used device.
-                else if (it = ranges::find_if(devices,
-                            [id=state()->value(STATE_LAST_DEVICE).toString()](const auto &d)
-                            { return d.id == id; });
-                         it != devices.end())
-                {
-                    api->playTrack(track, it->id);
-                    INFO << "Playing on last used device:" << it->name;
-                }
-
-                // Otherwise Use the first available device.
-                else
-                {
-                    api->playTrack(track, devices[0].id);
-                    INFO << "Playing on:" << devices[0].id;
-                    state()->setValue(STATE_LAST_DEVICE, devices[0].id);
-                }
-            }
-        );
-
-        actions.emplace_back("queue", "Add to the Spotify queue",
-                             [this, track] { api->addTrackToQueue(track); });
-
-        // For each device except active create action to transfer Spotify playback to this device.
-        for (const auto& device : api->getDevices())
-        {
-            if (device.isActive) continue;
-
-            actions.emplace_back(
-                QString("play_on_%1").arg(device.id),
-                QString("Play on %1 (%2)").arg(device.type, device.name),
-                [this, track, device]
-                {
-                    api->playTrack(track, device.id);
-                    state()->setValue(STATE_LAST_DEVICE, device.id);
-                }
-            );
-        }
+        const Metrics::StageTimer itemsTimer(metrics, "items");
+        addCollections(collections, devices, isNamedLikeQuery);
+        addTracks(tracks, devices);
+    }
+
+    // Nobody cancels the downloads, the covers are useful to later queries as well.
+    // Covers of every page are downloaded right away, not only once all pages arrived.
+    api->downloadFilesAsync(std::exchange(covers, {}));
+
+    if (!tracks->isEmpty())
+        prefetcher->prefetch(query.string(), tracks->first(), RemoteSearch::searchTypes(searchCollections()),
+                             firstPageSize);
+
+    // Further pages of tracks are appended while the query is valid and results are missing.
+    for (int page = 1; page < MAX_SEARCH_PAGES && !remote.isExhausted() && !isFull(); ++page)
+    {
+        auto pageTracks = remote.nextPage(pageSize(remaining()), isValid);
 
-        result->setActions(actions);
+        if (!pageTracks)
+            return;
 
-        query.add(result);
+        addTracks(make_shared<const QVector<Track>>(std::move(*pageTracks)), devices);
+        api->downloadFilesAsync(std::exchange(covers, {}));
+    }
+
+    addCollections(collections, devices, [](const Collection&) { return true; });
+    api->downloadFilesAsync(covers);
+}
+
+void Plugin::playOnPreferredDevice(const function<void(const QString& deviceId)>& play,
+                                   const function<void()>& waitAndPlay)
+{
+    // If we have no devices run local Spotify client
+    if (const auto devices = api->getDevices();
+        devices.isEmpty())
+    {
+        runDetachedProcess({spotify_command_});
+        waitAndPlay();
+        INFO << "Playing on local Spotify.";
+    }
+
+    // If available, use an active device.
+    else if (auto it = ranges::find_if(devices, &Device::isActive);
+        it != devices.cend())
+    {
+        play(it->id);
+        INFO << "Playing on active device:" << it->name;
+        state()->setValue(STATE_LAST_DEVICE, it->id);
+    }
+
+    // If available, use the last-used device.
+    else if (it = ranges::find_if(devices,
+                [id=state()->value(STATE_LAST_DEVICE).toString()](const auto &d)
+                { return d.id == id; });
+             it != devices.end())
+    {
+        play(it->id);
+        INFO << "Playing on last used device:" << it->name;
+    }
+
+    // Otherwise Use the first available device.
+    else
+    {
+        play(devices[0].id);
+        INFO << "Playing on:" << devices[0].id;
+        state()->setValue(STATE_LAST_DEVICE, devices[0].id);
     }
 }
 
@@ -200,6 +409,38 @@ QWidget* Plugin::buildConfigWidget()
     connect(ui.spinBox_number_of_results, &QSpinBox::valueChanged,
             this, &Plugin::setFetchCount);
 
+    ui.spinBox_parallel_downloads->setValue(parallelDownloads());
+    connect(ui.spinBox_parallel_downloads, &QSpinBox::valueChanged,
+            this, &Plugin::setParallelDownloads);
+
+    ui.spinBox_search_cache_size->setValue(searchCacheSize());
+    connect(ui.spinBox_search_cache_size, &QSpinBox::valueChanged,
+            this, &Plugin::setSearchCacheSize);
+
+    ui.spinBox_search_cache_ttl->setValue(searchCacheTimeToLive());
+    connect(ui.spinBox_search_cache_ttl, &QSpinBox::valueChanged,
+            this, &Plugin::setSearchCacheTimeToLive);
+
+    ui.spinBox_cover_cache_size->setValue(coverCacheSize());
+    connect(ui.spinBox_cover_cache_size, &QSpinBox::valueChanged,
+            this, &Plugin::setCoverCacheSize);
+
+    ui.checkBox_collect_statistics->setChecked(collectStatistics());
+    connect(ui.checkBox_collect_statistics, &QCheckBox::toggled,
+            this, &Plugin::setCollectStatistics);
+
+    ui.checkBox_library_index->setChecked(libraryIndexEnabled());
+    connect(ui.checkBox_library_index, &QCheckBox::toggled,
+            this, &Plugin::setLibraryIndexEnabled);
+
+    ui.checkBox_search_collections->setChecked(searchCollections());
+    connect(ui.checkBox_search_collections, &QCheckBox::toggled,
+            this, &Plugin::setSearchCollections);
+
+    ui.checkBox_prefetch->setChecked(prefetchEnabled());
+    connect(ui.checkBox_prefetch, &QCheckBox::toggled,
+            this, &Plugin::setPrefetchEnabled);
+
     ui.lineEdit_spotify_executable->setText(spotifyCommand());
     connect(ui.lineEdit_spotify_executable, &QLineEdit::textEdited,
             this, &Plugin::setSpotifyCommand);
@@ -226,6 +467,20 @@ QWidget* Plugin::buildConfigWidget()
         delete messageBox;
     });
 
+    // Bind "Statistics" button
+    connect(ui.pushButton_statistics, &QPushButton::clicked, this, [this]
+    {
+        const auto messageBox = new QMessageBox();
+        messageBox->setWindowTitle("Statistics");
+        messageBox->setText(api->metrics().isEnabled()
+                                ? "Statistics collected since the plugin was loaded."
+                                : "Statistics collection is disabled.");
+        messageBox->setDetailedText(QString("%1\n%2").arg(api->statisticsSummary(), prefetcher->summary()));
+        messageBox->setIcon(QMessageBox::Information);
+        messageBox->exec();
+        delete messageBox;
+    });
+
     return widget;
 }
 
@@ -284,6 +539,98 @@ void Plugin::setShowExplicitContent(bool v)
     settings()->setValue(CFG_ALLOW_EXPLICIT, v);
 }
 
+uint Plugin::parallelDownloads() const { return parallel_downloads_; }
+
+void Plugin::setParallelDownloads(uint v)
+{
+    if(parallel_downloads_ == v)
+        return;
+
+    parallel_downloads_ = v;
+    api->setMaxParallelDownloads(static_cast<int>(v));
+    settings()->setValue(CFG_PARALLEL_DOWNLOADS, v);
+}
+
+uint Plugin::searchCacheSize() const { return search_cache_size_; }
+
+void Plugin::setSearchCacheSize(uint v)
+{
+    if(search_cache_size_ == v)
+        return;
+
+    search_cache_size_ = v;
+    api->setSearchCacheSize(static_cast<int>(v));
+    settings()->setValue(CFG_SEARCH_CACHE_SIZE, v);
+}
+
+uint Plugin::coverCacheSize() const { return cover_cache_size_; }
+
+void Plugin::setCoverCacheSize(uint v)
+{
+    if(cover_cache_size_ == v)
+        return;
+
+    cover_cache_size_ = v;
+    coverStore->setMaxSize(static_cast<qint64>(v) * 1024 * 1024);
+    settings()->setValue(CFG_COVER_CACHE_SIZE, v);
+}
+
+uint Plugin::searchCacheTimeToLive() const { return search_cache_ttl_; }
+
+void Plugin::setSearchCacheTimeToLive(uint v)
+{
+    if(search_cache_ttl_ == v)
+        return;
+
+    search_cache_ttl_ = v;
+    api->setSearchCacheTimeToLive(static_cast<int>(v));
+    settings()->setValue(CFG_SEARCH_CACHE_TTL, v);
+}
+
+bool Plugin::collectStatistics() const { return api->metrics().isEnabled(); }
+
+void Plugin::setCollectStatistics(bool v)
+{
+    if(api->metrics().isEnabled() == v)
+        return;
+
+    api->metrics().setEnabled(v);
+    settings()->setValue(CFG_COLLECT_STATISTICS, v);
+}
+
+bool Plugin::libraryIndexEnabled() const { return librarySync->isEnabled(); }
+
+void Plugin::setLibraryIndexEnabled(bool v)
+{
+    if(librarySync->isEnabled() == v)
+        return;
+
+    librarySync->setEnabled(v);
+    settings()->setValue(CFG_LIBRARY_INDEX, v);
+}
+
+bool Plugin::searchCollections() const { return search_collections_; }
+
+void Plugin::setSearchCollections(bool v)
+{
+    if(search_collections_ == v)
+        return;
+
+    search_collections_ = v;
+    settings()->setValue(CFG_SEARCH_COLLECTIONS, v);
+}
+
+bool Plugin::prefetchEnabled() const { return prefetcher->isEnabled(); }
+
+void Plugin::setPrefetchEnabled(bool v)
+{
+    if(prefetcher->isEnabled() == v)
+        return;
+
+    prefetcher->setEnabled(v);
+    settings()->setValue(CFG_PREFETCH, v);
+}
+
 QString Plugin::spotifyCommand() const { return spotify_command_; }
 
 void Plugin::setSpotifyCommand(const QString &v)
@@ -3,7 +3,14 @@
 #pragma once
 #include <albert/extensionplugin.h>
 #include <albert/triggerqueryhandler.h>
+#include <functional>
 #include <memory>
+class CoverStore;
+class LibraryIndex;
+class LibrarySync;
+class PlayHistory;
+class Prefetcher;
+class ResultItems;
 class SpotifyApiClient;
 
 
@@ -36,15 +43,59 @@ public:
     bool showExplicitContent() const;
     void setShowExplicitContent(bool);
 
+    uint parallelDownloads() const;
+    void setParallelDownloads(uint);
+
+    uint searchCacheSize() const;
+    void setSearchCacheSize(uint);
+
+    uint coverCacheSize() const;
+    void setCoverCacheSize(uint);
+
+    uint searchCacheTimeToLive() const;
+    void setSearchCacheTimeToLive(uint);
+
+    bool collectStatistics() const;
+    void setCollectStatistics(bool);
+
+    bool libraryIndexEnabled() const;
+    void setLibraryIndexEnabled(bool);
+
+    bool searchCollections() const;
+    void setSearchCollections(bool);
+
+    bool prefetchEnabled() const;
+    void setPrefetchEnabled(bool);
+
     QString spotifyCommand() const;
     void setSpotifyCommand(const QString &);
 
 private:
 
+    /**
+     * Play on the active, the last used or the first available device.
+     * If there is no device, the local Spotify client is started and the playback waits for it.
+     * @param play Starts the playback on the device of the given ID.
+     * @param waitAndPlay Starts the playback once a device is ready.
+     */
+    void playOnPreferredDevice(const std::function<void(const QString& deviceId)>& play,
+                               const std::function<void()>& waitAndPlay);
+
     std::unique_ptr<SpotifyApiClient> api;
+    std::unique_ptr<LibraryIndex> library;
+    std::unique_ptr<LibrarySync> librarySync;
+    std::unique_ptr<PlayHistory> history;
+    std::unique_ptr<CoverStore> coverStore;
+    std::unique_ptr<Prefetcher> prefetcher;
+    std::unique_ptr<ResultItems> items;
 
     uint fetch_count_;
     bool show_explicit_content_;
     QString spotify_command_;
+    uint parallel_downloads_;
+    uint search_cache_size_;
+    uint search_cache_ttl_;
+    uint cover_cache_size_;
+    bool search_collections_;
 
 };
@@ -0,0 +1,158 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "coverStore.h"
+#include "prefetcher.h"
+#include "spotifyApiClient.h"
+#include <QDateTime>
+#include <QFuture>
+#include <albert/logging.h>
+Q_DECLARE_LOGGING_CATEGORY(AlbertLoggingCategory)
+using namespace std;
+
+inline qsizetype PREFETCH_BUDGET = 10;     // Prefetches per minute
+inline qint64 PREFETCH_WINDOW = 60000;     // Milliseconds the budget applies to
+inline qint64 PREFETCH_HIT_TTL = 120000;   // Milliseconds a prefetch counts as a hit if typed
+inline qsizetype PREFETCH_COVERS = 3;      // Covers of the top results downloaded per prefetch
+
+
+Prefetcher::Prefetcher(SpotifyApiClient& api, CoverStore& coverStore):
+    api(api),
+    coverStore(coverStore)
+{
+}
+
+bool Prefetcher::isEnabled() const { return enabled; }
+
+void Prefetcher::setEnabled(const bool enabled) { this->enabled = enabled; }
+
+void Prefetcher::recordQuery(const QString& query)
+{
+    QMutexLocker locker(&mutex);
+
+    // Every prefetch counts as a hit once, later keystrokes find it in the search cache anyway.
+    if (const auto it = pending.find(normalize(query));
+        it != pending.end())
+    {
+        if (QDateTime::currentMSecsSinceEpoch() - it.value() < PREFETCH_HIT_TTL)
+            ++hits;
+
+        pending.erase(it);
+    }
+}
+
+void Prefetcher::prefetch(const QString& query, const Track& top, const QStringList& types, const int limit)
+{
+    if (!enabled)
+        return;
+
+    // Real queries take all the budget the server allows, prefetches only what is left.
+    if (api.isServerUnreachable()
+        || api.rateLimitedFor(SpotifyApiClient::Lane::Search) > 0
+        || api.rateLimitedFor(SpotifyApiClient::Lane::Prefetch) > 0)
+        return;
+
+    const auto now = QDateTime::currentMSecsSinceEpoch();
+    QStringList queries;
+
+    {
+        QMutexLocker locker(&mutex);
+
+        issued.removeIf([now](const qint64 time) { return now - time >= PREFETCH_WINDOW; });
+        for (auto it = pending.begin(); it != pending.end();)
+            it = now - it.value() >= PREFETCH_HIT_TTL ? pending.erase(it) : next(it);
+
+        for (const auto& candidate : continuations(query, top))
+        {
+            if (issued.size() >= PREFETCH_BUDGET)
+                break;
+
+            if (pending.contains(candidate))
+                continue;
+
+            // Reserve the budget, it is released again if the cache answers the query.
+            issued.append(now);
+            pending.insert(candidate, now);
+            queries.append(candidate);
+        }
+    }
+
+    for (const auto& candidate : queries)
+    {
+        DEBG << "Prefetching search:" << candidate;
+
+        auto search = api.searchAsync(candidate, types, limit, 0, SpotifyApiClient::Lane::Prefetch);
+
+        // The search and disk caches answer right away. Such queries sent no request and are no prefetch.
+        {
+            QMutexLocker locker(&mutex);
+
+            if (search.isFinished())
+            {
+                issued.removeOne(now);
+                pending.remove(candidate);
+            }
+            else
+                ++prefetches;
+        }
+
+        // Covers of the top results make the prefetched items complete, the rest waits for a real query.
+        // The prefetcher is the context, so continuations of searches still running are dropped with it.
+        search.then(this, [this](const SearchResults& results)
+        {
+            QHash<QString, QString> covers;
+            for (const auto& track : results.tracks.first(min(results.tracks.size(), PREFETCH_COVERS)))
+                if (!coverStore.contains(track.albumId))
+                    covers.insert(coverStore.path(track.albumId), track.imageUrl);
+
+            api.downloadFilesAsync(covers);
+        });
+    }
+}
+
+QString Prefetcher::summary() const
+{
+    QMutexLocker locker(&mutex);
+
+    return QString("Prefetch\n  prefetches: %1, hits: %2 (%3 %)")
+        .arg(prefetches)
+        .arg(hits)
+        .arg(prefetches ? 100 * hits / prefetches : 0);
+}
+
+QStringList Prefetcher::continuations(const QString& query, const Track& top)
+{
+    const auto typed = normalize(query);
+    QStringList candidates;
+
+    // The artist of the top result, users often go on to type it.
+    if (const auto artist = normalize(top.artists.section(QStringLiteral(", "), 0, 0));
+        !artist.isEmpty())
+        candidates.append(artist);
+
+    // The word being typed completed by the title of the top result, or the next word of the title.
+    auto words = typed.split(' ', Qt::SkipEmptyParts);
+    const auto title = normalize(top.name).split(' ', Qt::SkipEmptyParts);
+
+    if (!words.isEmpty())
+    {
+        for (qsizetype i = 0; i < title.size(); ++i)
+        {
+            if (!title[i].startsWith(words.last()))
+                continue;
+
+            if (title[i].size() > words.last().size())
+                words.last() = title[i];
+            else if (i + 1 < title.size())
+                words.append(title[i + 1]);
+
+            candidates.append(words.join(' '));
+            break;
+        }
+    }
+
+    candidates.removeDuplicates();
+    candidates.removeAll(typed);
+    return candidates;
+}
+
+QString Prefetcher::normalize(const QString& query) { return query.simplified().toLower(); }
@@ -0,0 +1,81 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include "types/track.h"
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <atomic>
+class CoverStore;
+class SpotifyApiClient;
+
+
+/**
+ * Warms the search cache and the cover store with queries the user is likely to type next.
+ *
+ * Once a search is answered, the artist of its top result and the query continued by
+ * the next word of the title of the top result are searched in the prefetch lane of the
+ * client, which real queries always take precedence over. The prefetches are capped by
+ * a budget per minute, queries answered by the caches count neither as a prefetch nor
+ * against the budget. Queries typed by the user are checked against the recent
+ * prefetches to tell how many of them paid off.
+ * All methods may be called from any thread, the covers of prefetched results are
+ * requested on the thread of the prefetcher.
+ */
+class Prefetcher final : public QObject
+{
+public:
+    Prefetcher(SpotifyApiClient& api, CoverStore& coverStore);
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    /**
+     * Count a query typed by the user, a hit if it was prefetched recently.
+     * @param query The query string.
+     */
+    void recordQuery(const QString& query);
+
+    /**
+     * Prefetch likely continuations of an answered query, as far as the budget allows.
+     * Types and limit have to match the ones of the first search page of a query,
+     * otherwise the prefetched results are cached under a different key.
+     * @param query The answered query string.
+     * @param top The top track found by the query.
+     * @param types Result types of the first search page.
+     * @param limit Number of results of the first search page.
+     */
+    void prefetch(const QString& query, const Track& top, const QStringList& types, int limit);
+
+    /**
+     * Returns human-readable summary of the prefetches and their hit rate.
+     */
+    QString summary() const;
+
+private:
+    Q_OBJECT
+
+    SpotifyApiClient& api;
+    CoverStore& coverStore;
+    std::atomic<bool> enabled = false;
+
+    mutable QMutex mutex;
+    QList<qint64> issued;            // Times of prefetches within the last minute
+    QHash<QString, qint64> pending;  // Prefetched queries not typed yet, mapped to the time of the prefetch
+    quint64 prefetches = 0;
+    quint64 hits = 0;
+
+    /**
+     * Returns normalized queries likely to follow the given one.
+     * @param query The answered query string.
+     * @param top The top track found by the query.
+     */
+    static QStringList continuations(const QString& query, const Track& top);
+
+    /**
+     * Normalize a query, so queries differing in case or whitespace are equal.
+     */
+    static QString normalize(const QString& query);
+};
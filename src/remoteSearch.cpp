@@ -0,0 +1,110 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "remoteSearch.h"
+using namespace std;
+
+inline QStringList TRACK_TYPES = {"track"};
+inline QStringList ALL_TYPES = {"track", "album", "artist", "playlist"};
+
+
+RemoteSearch::RemoteSearch(SpotifyApiClient& api, QString query, const int limit, const bool withCollections):
+    api(api),
+    query(std::move(query)),
+    limit(limit),
+    withCollections(withCollections),
+    unreachable(api.isServerUnreachable())
+{
+    if (!unreachable)
+        devices = api.getDevicesAsync();
+}
+
+QVector<Device> RemoteSearch::readyDevices() const
+{
+    return !unreachable && devices.isFinished() ? devices.result() : QVector<Device>();
+}
+
+RemoteSearch::Result RemoteSearch::run(const SpotifyApiClient::Validity& isValid)
+{
+    Result result;
+
+    if (unreachable)
+    {
+        result.status = Status::Offline;
+        return result;
+    }
+
+    // A search sent now would only wait for the pause of the lane to pass.
+    if (api.rateLimitedFor(SpotifyApiClient::Lane::Search) > 0)
+    {
+        result.status = Status::RateLimited;
+        return result;
+    }
+
+    // Search and devices wait for the token on the client side, so an expired token
+    // delays them by a single refresh shared with the token check. All result types
+    // are asked for by a single request.
+    const auto token = api.ensureAccessTokenAsync();
+    const auto search = api.searchAsync(query, searchTypes(withCollections), limit);
+
+    if (!api.metrics().measure("requests", [&]
+        { return SpotifyApiClient::waitForAll(isValid, token, search, devices); }))
+        return result;
+
+    // The token is refreshed in the background, if it still expired, tell whether
+    // the server is unreachable or the credentials are wrong.
+    if (!token.result())
+    {
+        result.status = api.isServerUnreachable() ? Status::Offline : Status::WrongCredentials;
+        return result;
+    }
+
+    result.results = search.result();
+    const auto isEmpty = result.results.tracks.isEmpty() && result.results.collections.isEmpty();
+
+    // The requests above refreshed the reachability verdict, so this tells why there are no results.
+    if (isEmpty && api.isServerUnreachable())
+    {
+        result.status = Status::Offline;
+        return result;
+    }
+
+    if (isEmpty && api.rateLimitedFor(SpotifyApiClient::Lane::Search) > 0)
+    {
+        result.status = Status::RateLimited;
+        return result;
+    }
+
+    // A page shorter than requested is the last one.
+    offset = result.results.tracks.size();
+    exhausted = offset < limit;
+
+    // Devices are fetched once for all results, the action lambdas share the cached list as well.
+    result.devices = devices.result();
+    result.status = Status::Found;
+    return result;
+}
+
+optional<QVector<Track>> RemoteSearch::nextPage(const int limit, const SpotifyApiClient::Validity& isValid)
+{
+    const auto next = api.searchAsync(query, TRACK_TYPES, limit, static_cast<int>(offset));
+
+    if (!SpotifyApiClient::waitForAll(isValid, next))
+        return nullopt;
+
+    api.metrics().increment("search pages");
+
+    auto tracks = next.result().tracks;
+    offset += tracks.size();
+    exhausted = tracks.size() < limit;
+    return tracks;
+}
+
+bool RemoteSearch::isExhausted() const { return exhausted; }
+
+RemoteSearch::Result RemoteSearch::fetch(SpotifyApiClient& api, const QString& query, const int limit,
+                                         const bool withCollections, const SpotifyApiClient::Validity& isValid)
+{
+    return RemoteSearch(api, query, limit, withCollections).run(isValid);
+}
+
+QStringList RemoteSearch::searchTypes(const bool withCollections) { return withCollections ? ALL_TYPES : TRACK_TYPES; }
@@ -0,0 +1,101 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include "spotifyApiClient.h"
+#include "types/device.h"
+#include "types/searchResults.h"
+#include <QFuture>
+#include <QString>
+#include <QVector>
+#include <optional>
+
+
+/**
+ * The Web API part of a query, everything it needs from the server before its items are built.
+ *
+ * The query handler and the latency benchmark both run queries through it,
+ * so the benchmark measures the requests the plugin actually sends.
+ */
+class RemoteSearch
+{
+public:
+    enum class Status
+    {
+        Found,              // The search was answered, possibly with no results
+        Offline,            // The server can't be reached
+        WrongCredentials,   // No access token could be obtained
+        RateLimited,        // The search lane is paused by the server
+        Cancelled           // The query was superseded
+    };
+
+    struct Result
+    {
+        Status status = Status::Cancelled;
+        SearchResults results;
+        QVector<Device> devices;
+    };
+
+    /**
+     * Request the device list right away, so results shown before the search can offer
+     * the devices if they are cached. Nothing is sent if the server is known to be unreachable.
+     * @param api The client to send the requests with.
+     * @param query The search query.
+     * @param limit Maximum number of results of each type on the first page.
+     * @param withCollections Search albums, artists and playlists along with the tracks.
+     */
+    RemoteSearch(SpotifyApiClient& api, QString query, int limit, bool withCollections);
+
+    /**
+     * Returns the devices if they were served from the cache right away, empty otherwise.
+     */
+    QVector<Device> readyDevices() const;
+
+    /**
+     * Send the token check and the search and wait for them together with the devices.
+     * @param isValid Requests are aborted once this returns false.
+     * @return The results and devices if the status is Found.
+     */
+    Result run(const SpotifyApiClient::Validity& isValid);
+
+    /**
+     * Search the page of tracks following the results of run and of the previous pages.
+     * Collections are not paged, the first page has all of them that are shown.
+     * @param limit Maximum number of tracks, at most the Web API limit of 50.
+     * @param isValid The request is aborted once this returns false.
+     * @return The tracks of the page, nullopt if the query was superseded.
+     */
+    std::optional<QVector<Track>> nextPage(int limit, const SpotifyApiClient::Validity& isValid);
+
+    /**
+     * Returns true if the last page was shorter than requested, so there are no further tracks.
+     */
+    bool isExhausted() const;
+
+    /**
+     * Search tracks and possibly collections and fetch the devices to play them on.
+     * @param api The client to send the requests with.
+     * @param query The search query.
+     * @param limit Maximum number of results of each type.
+     * @param withCollections Search albums, artists and playlists along with the tracks.
+     * @param isValid Requests are aborted once this returns false.
+     * @return The results and devices if the status is Found.
+     */
+    static Result fetch(SpotifyApiClient& api, const QString& query, int limit, bool withCollections,
+                        const SpotifyApiClient::Validity& isValid);
+
+    /**
+     * Returns the result types of the first page, searches of other types are cached under other keys.
+     * @param withCollections Search albums, artists and playlists along with the tracks.
+     */
+    static QStringList searchTypes(bool withCollections);
+
+private:
+    SpotifyApiClient& api;
+    QString query;
+    int limit;
+    bool withCollections;
+    bool unreachable;
+    QFuture<QVector<Device>> devices;
+    qsizetype offset = 0;
+    bool exhausted = true;
+};
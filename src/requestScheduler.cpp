@@ -0,0 +1,115 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "requestScheduler.h"
+#include <QDateTime>
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+// Spotify does not publish its limits, the budgets stay well below the observed ones.
+// Burst sizes and refill rates in requests per second.
+inline double SEARCH_BURST = 10, SEARCH_RATE = 5;
+inline double DEVICES_BURST = 3, DEVICES_RATE = 0.5;
+inline double COVERS_BURST = 20, COVERS_RATE = 20;
+inline double PREFETCH_BURST = 5, PREFETCH_RATE = 1;
+inline double API_BURST = 20, API_RATE = 8;
+
+
+RequestScheduler::RequestScheduler()
+{
+    const auto configure = [this](const Lane lane, const double burst, const double rate, const bool sharesApiBudget)
+    {
+        auto& state = lanes[static_cast<size_t>(lane)];
+        state.bucket = Bucket{.capacity = burst, .rate = rate, .tokens = burst};
+        state.sharesApiBudget = sharesApiBudget;
+    };
+
+    configure(Lane::Search, SEARCH_BURST, SEARCH_RATE, true);
+    configure(Lane::Devices, DEVICES_BURST, DEVICES_RATE, true);
+    configure(Lane::Covers, COVERS_BURST, COVERS_RATE, false);
+    configure(Lane::Prefetch, PREFETCH_BURST, PREFETCH_RATE, true);
+    api = Bucket{.capacity = API_BURST, .rate = API_RATE, .tokens = API_BURST};
+
+    timer.setSingleShot(true);
+    QObject::connect(&timer, &QTimer::timeout, [this] { dispatch(); });
+}
+
+void RequestScheduler::schedule(const Lane lane, function<bool()> send)
+{
+    lanes[static_cast<size_t>(lane)].queue.append(std::move(send));
+
+    // Requests queued while sending others are picked up by the running round.
+    if (!dispatching)
+        dispatch();
+}
+
+void RequestScheduler::pause(const Lane lane, const qint64 msecs)
+{
+    auto& pausedUntil = lanes[static_cast<size_t>(lane)].pausedUntil;
+    pausedUntil = max(pausedUntil.load(), QDateTime::currentMSecsSinceEpoch() + msecs);
+    dispatch();
+}
+
+qint64 RequestScheduler::pausedFor(const Lane lane) const
+{
+    return max<qint64>(lanes[static_cast<size_t>(lane)].pausedUntil - QDateTime::currentMSecsSinceEpoch(), 0);
+}
+
+void RequestScheduler::Bucket::refill(const qint64 now)
+{
+    if (refilled)
+        tokens = min(capacity, tokens + rate * static_cast<double>(now - refilled) / 1000.0);
+    refilled = now;
+}
+
+qint64 RequestScheduler::Bucket::wait() const
+{
+    return tokens >= 1.0 ? 0 : static_cast<qint64>(ceil((1.0 - tokens) / rate * 1000.0));
+}
+
+void RequestScheduler::dispatch()
+{
+    if (dispatching)
+        return;
+
+    dispatching = true;
+
+    const auto now = QDateTime::currentMSecsSinceEpoch();
+    api.refill(now);
+
+    // Higher lanes take the shared budget first, a lower lane gets only what they leave.
+    for (auto& lane : lanes)
+    {
+        lane.bucket.refill(now);
+
+        while (!lane.queue.isEmpty() && lane.pausedUntil <= now
+               && lane.bucket.tokens >= 1.0 && (!lane.sharesApiBudget || api.tokens >= 1.0))
+        {
+            if (lane.queue.takeFirst()())
+            {
+                lane.bucket.tokens -= 1.0;
+                if (lane.sharesApiBudget)
+                    api.tokens -= 1.0;
+            }
+        }
+    }
+
+    dispatching = false;
+
+    // Planned after sending, senders may have queued requests to lanes already passed.
+    qint64 next = -1;  // Milliseconds until the next round, none if nothing waits
+    for (const auto& lane : lanes)
+    {
+        if (lane.queue.isEmpty())
+            continue;
+
+        auto wait = max(lane.pausedUntil - now, lane.bucket.wait());
+        if (lane.sharesApiBudget)
+            wait = max(wait, api.wait());
+
+        next = next < 0 ? wait : min(next, wait);
+    }
+
+    if (next >= 0)
+        timer.start(static_cast<int>(clamp<qint64>(next, 1, numeric_limits<int>::max())));
+}
@@ -0,0 +1,95 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include <QList>
+#include <QTimer>
+#include <array>
+#include <atomic>
+#include <functional>
+
+
+/**
+ * Paces requests by token buckets, so bursts of typing do not run into rate limits.
+ *
+ * Requests wait in lanes of their endpoint class. Every lane has its own bucket, lanes of
+ * the Web API share one more bucket for the whole application, which the lanes draw from
+ * in the order of their priority. A lane the server answered with 429 Too Many Requests
+ * is paused until the Retry-After delay passes, other lanes keep going.
+ * All methods except pausedFor must be called on the thread of the scheduler.
+ */
+class RequestScheduler
+{
+public:
+    /**
+     * Endpoint classes in the order of their priority.
+     */
+    enum class Lane
+    {
+        Search,    // Searches the user is waiting for
+        Devices,   // Device lists for playback actions
+        Covers,    // Cover images from the image CDN, not counted to the Web API budget
+        Prefetch,  // Background work like revalidation, library sync and prefetching
+    };
+
+    RequestScheduler();
+
+    /**
+     * Queue a request and send it as soon as the budget of its lane allows.
+     * Sends right away if there is budget left, even before this returns.
+     * @param lane The lane of the request.
+     * @param send Sends the request, returns false if it was not wanted anymore and used no budget.
+     */
+    void schedule(Lane lane, std::function<bool()> send);
+
+    /**
+     * Pause a lane, e.g. once the server asked to retry after a delay.
+     * @param lane The lane to pause.
+     * @param msecs Duration of the pause in milliseconds.
+     */
+    void pause(Lane lane, qint64 msecs);
+
+    /**
+     * Returns remaining milliseconds of the pause of the lane, zero if it is not paused.
+     * May be called from any thread.
+     */
+    qint64 pausedFor(Lane lane) const;
+
+private:
+    struct Bucket
+    {
+        double capacity;
+        double rate;  // Tokens per second
+        double tokens;
+        qint64 refilled = 0;
+
+        /**
+         * Add the tokens accumulated since the last refill.
+         */
+        void refill(qint64 now);
+
+        /**
+         * Returns milliseconds until there is a whole token.
+         */
+        qint64 wait() const;
+    };
+
+    struct LaneState
+    {
+        Bucket bucket;
+        bool sharesApiBudget;
+        std::atomic<qint64> pausedUntil = 0;
+        QList<std::function<bool()>> queue;
+    };
+
+    static constexpr auto LANE_COUNT = static_cast<size_t>(Lane::Prefetch) + 1;
+
+    std::array<LaneState, LANE_COUNT> lanes;
+    Bucket api;
+    QTimer timer;
+    bool dispatching = false;
+
+    /**
+     * Send queued requests the budget allows and plan the next round.
+     */
+    void dispatch();
+};
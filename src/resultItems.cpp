@@ -0,0 +1,96 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "resultItems.h"
+#include <albert/standarditem.h>
+using namespace albert;
+using namespace std;
+
+inline auto COVER_PLACEHOLDER = "xdg:spotify";  // Icon of items whose cover is not downloaded yet
+
+
+ResultItems::ResultItems(Handlers handlers):
+    handlers(std::move(handlers))
+{}
+
+shared_ptr<StandardItem> ResultItems::buildTrackItem(const shared_ptr<const Track>& track,
+                                                     const QVector<Device>& devices, const QString& coverPath) const
+{
+    // Create a standard item with a track name in title and album with artists in subtext.
+    const auto result = StandardItem::make(
+        track->id,
+        track->name,
+        QString("%1 (%2)").arg(track->albumName, track->artists),
+        nullptr,
+        {coverPath, COVER_PLACEHOLDER});
+
+    auto actions = vector<Action>();
+
+    actions.emplace_back("play", "Play on Spotify",
+                         [this, track] { handlers.play(*track); });
+
+    actions.emplace_back("queue", "Add to the Spotify queue",
+                         [this, track] { handlers.queue(*track); });
+
+    // For each device except active create action to transfer Spotify playback to this device.
+    for (const auto& device : devices)
+    {
+        if (device.isActive) continue;
+
+        actions.emplace_back(
+            QString("play_on_%1").arg(device.id),
+            QString("Play on %1 (%2)").arg(device.type, device.name),
+            [this, track, deviceId = device.id] { handlers.playOn(*track, deviceId); }
+        );
+    }
+
+    result->setActions(actions);
+
+    return result;
+}
+
+shared_ptr<StandardItem> ResultItems::buildCollectionItem(const shared_ptr<const Collection>& collection,
+                                                          const QVector<Device>& devices,
+                                                          const QString& coverPath) const
+{
+    QString subtext;
+    switch (collection->type)
+    {
+    case Collection::Type::Album:
+        subtext = QString("Album (%1)").arg(collection->creator);
+        break;
+    case Collection::Type::Artist:
+        subtext = "Artist";
+        break;
+    case Collection::Type::Playlist:
+        subtext = QString("Playlist (%1)").arg(collection->creator);
+        break;
+    }
+
+    const auto result = StandardItem::make(
+        collection->id,
+        collection->name,
+        subtext,
+        nullptr,
+        {coverPath, COVER_PLACEHOLDER});
+
+    auto actions = vector<Action>();
+
+    actions.emplace_back("play", "Play on Spotify",
+                         [this, collection] { handlers.playCollection(*collection); });
+
+    // Collections can not be queued, the queue takes tracks only.
+    for (const auto& device : devices)
+    {
+        if (device.isActive) continue;
+
+        actions.emplace_back(
+            QString("play_on_%1").arg(device.id),
+            QString("Play on %1 (%2)").arg(device.type, device.name),
+            [this, collection, deviceId = device.id] { handlers.playCollectionOn(*collection, deviceId); }
+        );
+    }
+
+    result->setActions(actions);
+
+    return result;
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include "types/collection.h"
+#include "types/device.h"
+#include "types/track.h"
+#include <QString>
+#include <QVector>
+#include <functional>
+#include <memory>
+namespace albert { class StandardItem; }
+
+
+/**
+ * Builds result items and their actions.
+ *
+ * What the actions do is up to the handlers, so the plugin and the item benchmark
+ * build their items by the same code.
+ */
+class ResultItems
+{
+public:
+    struct Handlers
+    {
+        std::function<void(const Track&)> play;                            // Play on the preferred device
+        std::function<void(const Track&, const QString& deviceId)> playOn; // Play on the given device
+        std::function<void(const Track&)> queue;                           // Add to the queue
+        std::function<void(const Collection&)> playCollection;             // Play on the preferred device
+        std::function<void(const Collection&, const QString& deviceId)> playCollectionOn;  // Play on the given device
+    };
+
+    explicit ResultItems(Handlers handlers);
+
+    /**
+     * Build a result item of a track with actions to play or queue it.
+     * @param track The track of the item, shared by the item actions.
+     * @param devices Available devices to offer playback on.
+     * @param coverPath Path to the cover image of the album, a placeholder is shown while it is missing.
+     */
+    std::shared_ptr<albert::StandardItem> buildTrackItem(const std::shared_ptr<const Track>& track,
+                                                         const QVector<Device>& devices,
+                                                         const QString& coverPath) const;
+
+    /**
+     * Build a result item of an album, artist or playlist with actions to play it.
+     * @param collection The collection of the item, shared by the item actions.
+     * @param devices Available devices to offer playback on.
+     * @param coverPath Path to the cover image of the collection, a placeholder is shown while it is missing.
+     */
+    std::shared_ptr<albert::StandardItem> buildCollectionItem(const std::shared_ptr<const Collection>& collection,
+                                                              const QVector<Device>& devices,
+                                                              const QString& coverPath) const;
+
+private:
+    const Handlers handlers;
+};
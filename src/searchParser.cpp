@@ -0,0 +1,236 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#include "searchParser.h"
+#include <QStringList>
+#include <limits>
+#include <optional>
+using namespace std;
+
+inline qint64 ICON_IMAGE_SIZE = 64;  // Smallest image width still sharp as an item icon
+
+
+SearchParser::SearchParser(const QByteArrayView json):
+    reader(json)
+{
+}
+
+SearchResults SearchParser::parse(const QByteArrayView json)
+{
+    SearchParser parser(json);
+    auto& reader = parser.reader;
+    SearchResults results;
+    string_view key;
+
+    if (!reader.enterObject())
+        return {};
+
+    // Every result type has a paging object of its own, other members of it are skipped unread.
+    while (reader.nextMember(key))
+    {
+        optional<Collection::Type> type;
+
+        if (key == "albums")
+            type = Collection::Type::Album;
+        else if (key == "artists")
+            type = Collection::Type::Artist;
+        else if (key == "playlists")
+            type = Collection::Type::Playlist;
+        else if (key != "tracks")
+        {
+            reader.skip();
+            continue;
+        }
+
+        if (!reader.enterObject())
+            continue;
+
+        while (reader.nextMember(key))
+        {
+            if (key != "items")
+            {
+                reader.skip();
+                continue;
+            }
+
+            if (!reader.enterArray())
+                continue;
+
+            // Items may be null, e.g. playlists not available in the market of the user.
+            while (reader.nextElement())
+            {
+                if (!type)
+                {
+                    if (auto track = parser.readTrack(); !track.id.isEmpty())
+                        results.tracks.append(std::move(track));
+                }
+                else if (auto collection = parser.readCollection(*type); !collection.id.isEmpty())
+                    results.collections.append(std::move(collection));
+            }
+        }
+    }
+
+    if (reader.hasError())
+        return {};
+
+    return results;
+}
+
+Track SearchParser::readTrack()
+{
+    auto track = Track();
+    string_view key;
+
+    if (!reader.enterObject())
+        return track;
+
+    while (reader.nextMember(key))
+    {
+        if (key == "id")
+            track.id = reader.readString();
+        else if (key == "name")
+            track.name = reader.readString();
+        else if (key == "uri")
+            track.uri = reader.readString();
+        else if (key == "explicit")
+            track.isExplicit = reader.readBool();
+        else if (key == "artists")
+            track.artists = readArtists();
+        else if (key == "album")
+            readAlbum(track);
+        else
+            reader.skip();
+    }
+
+    return track;
+}
+
+Collection SearchParser::readCollection(const Collection::Type type)
+{
+    auto collection = Collection();
+    collection.type = type;
+    string_view key;
+
+    if (!reader.enterObject())
+        return collection;
+
+    while (reader.nextMember(key))
+    {
+        if (key == "id")
+            collection.id = reader.readString();
+        else if (key == "name")
+            collection.name = reader.readString();
+        else if (key == "uri")
+            collection.uri = reader.readString();
+        else if (key == "images")
+            collection.imageUrl = readImage();
+        else if (key == "artists")
+            collection.creator = readArtists();
+        else if (key == "owner" && reader.enterObject())
+        {
+            while (reader.nextMember(key))
+            {
+                if (key == "display_name")
+                    collection.creator = readInterned();
+                else
+                    reader.skip();
+            }
+        }
+        else if (key != "owner")
+            reader.skip();
+    }
+
+    return collection;
+}
+
+void SearchParser::readAlbum(Track& track)
+{
+    string_view key;
+
+    if (!reader.enterObject())
+        return;
+
+    while (reader.nextMember(key))
+    {
+        if (key == "id")
+            track.albumId = readInterned();
+        else if (key == "name")
+            track.albumName = readInterned();
+        else if (key == "images")
+            track.imageUrl = readImage();
+        else
+            reader.skip();
+    }
+}
+
+QString SearchParser::readImage()
+{
+    // Images are sorted from the largest one, but their sizes are unknown for some playlists.
+    QString best;
+    QString smallest;
+    auto bestWidth = numeric_limits<qint64>::max();
+    string_view key;
+
+    if (!reader.enterArray())
+        return {};
+
+    while (reader.nextElement())
+    {
+        if (!reader.enterObject())
+            continue;
+
+        QString url;
+        qint64 width = 0;
+
+        while (reader.nextMember(key))
+        {
+            if (key == "url")
+                url = readInterned();
+            else if (key == "width")
+                width = reader.readInteger();
+            else
+                reader.skip();
+        }
+
+        if (width >= ICON_IMAGE_SIZE && width < bestWidth)
+        {
+            best = url;
+            bestWidth = width;
+        }
+
+        smallest = url;
+    }
+
+    return best.isEmpty() ? smallest : best;
+}
+
+QString SearchParser::readArtists()
+{
+    QStringList artists;
+    string_view key;
+
+    if (!reader.enterArray())
+        return {};
+
+    while (reader.nextElement())
+    {
+        if (!reader.enterObject())
+            continue;
+
+        while (reader.nextMember(key))
+        {
+            if (key == "name")
+                artists.append(reader.readString());
+            else
+                reader.skip();
+        }
+    }
+
+    return intern(artists.join(", "));
+}
+
+QString SearchParser::readInterned() { return intern(reader.readString()); }
+
+QString SearchParser::intern(const QString& string)
+{
+    return *strings.insert(string);
+}
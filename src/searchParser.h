@@ -0,0 +1,75 @@
+// Copyright (c) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include "jsonReader.h"
+#include "types/searchResults.h"
+#include <QByteArrayView>
+#include <QSet>
+#include <QVector>
+
+
+/**
+ * Parser of Web API search responses.
+ * It extracts only the fields of the result types straight from the raw
+ * UTF-8 payload, without building an intermediate JSON document.
+ * Strings repeated within one response, e.g. album and artist names,
+ * are interned so all results share a single copy.
+ */
+class SearchParser
+{
+public:
+    /**
+     * Parse tracks, albums, artists and playlists of a search response.
+     * Result types missing in the response are left empty.
+     * @param json The raw response body.
+     * @return The parsed results, empty if the response is malformed.
+     */
+    static SearchResults parse(QByteArrayView json);
+
+protected:
+    explicit SearchParser(QByteArrayView json);
+
+    JsonReader reader;
+    QSet<QString> strings;
+
+    /**
+     * Read a string value and return the interned copy of it.
+     */
+    QString readInterned();
+
+    /**
+     * Return the interned copy of a string, sharing its data with equal strings.
+     */
+    QString intern(const QString& string);
+
+    /**
+     * Parse the track object at the current position.
+     * @return The parsed track object.
+     */
+    Track readTrack();
+
+    /**
+     * Parse the album, artist or playlist object at the current position.
+     * @param type The type of the object.
+     * @return The parsed collection, with an empty ID if it is null.
+     */
+    Collection readCollection(Collection::Type type);
+
+    /**
+     * Parse the album object at the current position into the track.
+     * @param track The track to fill in.
+     */
+    void readAlbum(Track& track);
+
+    /**
+     * Parse the array of images at the current position to the URL of the smallest one
+     * that is still large enough for an item icon.
+     */
+    QString readImage();
+
+    /**
+     * Parse the array of artists at the current position to a single string.
+     * @return String of artists separated by commas.
+     */
+    QString readArtists();
+};
@@ -1,256 +1,1043 @@
 // Copyright (c) 2020-2025 Ivo Šmerek
 
+#include "searchParser.h"
 #include "spotifyApiClient.h"
-#include <QEventLoop>
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QNetworkInformation>
 #include <QNetworkReply>
+#include <QPromise>
+#include <QRandomGenerator>
 #include <QSaveFile>
+#include <QThread>
 #include <albert/albert.h>
 #include <albert/logging.h>
+#include <algorithm>
+#include <type_traits>
+Q_DECLARE_LOGGING_CATEGORY(AlbertLoggingCategory)
 using namespace albert;
 using namespace std;
 
-inline QString TOKEN_URL = "https://accounts.spotify.com/api/token";
-inline QString SEARCH_URL = "https://api.spotify.com/v1/search?q=%1&type=%2&limit=%3";
-inline QString DEVICES_URL = "https://api.spotify.com/v1/me/player/devices";
-inline QString QUEUE_URL = "https://api.spotify.com/v1/me/player/queue?uri=%1";
-inline QString PLAY_URL = "https://api.spotify.com/v1/me/player/play?device_id=%1";
+// Base URLs can be overridden to point the client to a local stand-in server.
+inline QString ACCOUNTS_URL = qEnvironmentVariable("ALBERT_SPOTIFY_ACCOUNTS_URL", "https://accounts.spotify.com");
+inline QString API_URL = qEnvironmentVariable("ALBERT_SPOTIFY_API_URL", "https://api.spotify.com");
+inline QString TOKEN_URL = ACCOUNTS_URL + "/api/token";
+inline QString SEARCH_URL = API_URL + "/v1/search?q=%1&type=%2&limit=%3&offset=%4";
+inline QString DEVICES_URL = API_URL + "/v1/me/player/devices";
+inline QString QUEUE_URL = API_URL + "/v1/me/player/queue?uri=%1";
+inline QString PLAY_URL = API_URL + "/v1/me/player/play?device_id=%1";
+inline QString IMAGES_HOST = "i.scdn.co";
 inline int DEFAULT_TIMEOUT = 10000;
+inline int VALIDITY_POLL_INTERVAL = 20;
+inline qint64 TOKEN_REFRESH_MARGIN = 120000;
+inline int TOKEN_REFRESH_JITTER = 30000;
+inline int TOKEN_RETRY_MIN_DELAY = 5000;
+inline int TOKEN_RETRY_MAX_DELAY = 300000;
+inline qint64 DEVICES_CACHE_TTL = 10000;
+inline qsizetype DEFAULT_SEARCH_CACHE_SIZE = 100;
+inline qint64 DEFAULT_SEARCH_CACHE_TTL = 300000;
+inline qint64 DISK_CACHE_STALE_AGE = 604800000;
+inline qint64 DISK_CACHE_MAX_SIZE = 20 * 1024 * 1024;
+inline qint64 REACHABILITY_OFFLINE_TTL = 5000;
+inline qint64 CONNECTION_WARMUP_INTERVAL = 30000;
+inline qint64 DEFAULT_RETRY_AFTER = 1000;
+
+
+template<typename T>
+static shared_ptr<QPromise<T>> makePromise()
+{
+    const auto promise = make_shared<QPromise<T>>();
+    promise->start();
+    return promise;
+}
+
+template<typename T>
+static void fulfill(QPromise<T>& promise, type_identity_t<T> value)
+{
+    promise.addResult(std::move(value));
+    promise.finish();
+}
+
+template<typename T>
+static QFuture<T> readyFuture(T value)
+{
+    QPromise<T> promise;
+    promise.start();
+    fulfill(promise, std::move(value));
+    return promise.future();
+}
+
+template<typename T>
+static SpotifyApiClient::Validity isWantedBy(const shared_ptr<QPromise<T>>& promise)
+{
+    // Cancelling the future of a promise tells that nobody waits for it anymore.
+    return [promise] { return !promise->isCanceled(); };
+}
 
 
 SpotifyApiClient::SpotifyApiClient(QString id, QString secret, QString token):
     clientId_(id),
     clientSecret_(secret),
-    refreshToken_(token)
+    refreshToken_(token),
+    tokenRetryDelay(TOKEN_RETRY_MIN_DELAY),
+    searchCache(DEFAULT_SEARCH_CACHE_SIZE, DEFAULT_SEARCH_CACHE_TTL),
+    diskCacheFreshAge(DEFAULT_SEARCH_CACHE_TTL)
 {
+    // Entries past the stale age are never used again, so they do not need to be kept.
+    diskCache.setMaxAge(DISK_CACHE_STALE_AGE);
+    diskCache.setMaxSize(DISK_CACHE_MAX_SIZE);
+
+    tokenRefreshTimer.setSingleShot(true);
+    connect(&tokenRefreshTimer, &QTimer::timeout, this, &SpotifyApiClient::refreshAccessTokenInBackground);
+
+    cancellationTimer.setInterval(VALIDITY_POLL_INTERVAL);
+    connect(&cancellationTimer, &QTimer::timeout, this, &SpotifyApiClient::dropUnwantedRequests);
+
+    // Forget the cached verdict whenever the system reports a change of connectivity.
+    if (QNetworkInformation::loadBackendByFeatures(QNetworkInformation::Feature::Reachability))
+    {
+        connect(QNetworkInformation::instance(), &QNetworkInformation::reachabilityChanged,
+                this, [this](const QNetworkInformation::Reachability state)
+        {
+            setReachability(state == QNetworkInformation::Reachability::Disconnected
+                                ? Reachability::Offline
+                                : Reachability::Unknown);
+        });
+    }
 }
 
 QString SpotifyApiClient::clientId() { return clientId_; }
 
-void SpotifyApiClient::setClientId(const QString &id) { clientId_ = id; }
+void SpotifyApiClient::setClientId(const QString &id)
+{
+    clientId_ = id;
+    credentialsRejected = false;
+}
 
 QString SpotifyApiClient::clientSecret() { return clientSecret_; }
 
-void SpotifyApiClient::setClientSecret(const QString &secret) { clientSecret_ = secret; }
+void SpotifyApiClient::setClientSecret(const QString &secret)
+{
+    clientSecret_ = secret;
+    credentialsRejected = false;
+}
 
 QString SpotifyApiClient::refreshToken() { return refreshToken_; }
 
-void SpotifyApiClient::setRefreshToken(const QString &token) { refreshToken_ = token; }
+void SpotifyApiClient::setRefreshToken(const QString &token)
+{
+    refreshToken_ = token;
+    credentialsRejected = false;
+}
+
+void SpotifyApiClient::setCacheDirectory(const QString& path) { diskCache.setDirectory(path); }
+
+quint64 SpotifyApiClient::cancelledRequestCount() const { return cancelledRequests; }
+
+quint64 SpotifyApiClient::completedRequestCount() const { return completedRequests; }
+
+quint64 SpotifyApiClient::coalescedRequestCount() const { return coalescedRequests; }
+
+qint64 SpotifyApiClient::rateLimitedFor(const Lane lane) const { return scheduler.pausedFor(lane); }
+
+Metrics& SpotifyApiClient::metrics() { return metrics_; }
+
+QString SpotifyApiClient::statisticsSummary() const
+{
+    return QString("%1\nClient\n"
+                   "  search cache: %2 hits, %3 misses\n"
+                   "  device fetches: %4\n"
+                   "  requests: %5 completed, %6 cancelled, %7 coalesced")
+        .arg(metrics_.summary())
+        .arg(searchCacheHits())
+        .arg(searchCacheMisses())
+        .arg(deviceFetchCount())
+        .arg(completedRequestCount())
+        .arg(cancelledRequestCount())
+        .arg(coalescedRequestCount());
+}
 
 bool SpotifyApiClient::isAccessTokenExpired() const
 {
+    QMutexLocker locker(&tokenMutex);
     return QDateTime::currentDateTime() > expirationTime;
 }
 
+QFuture<bool> SpotifyApiClient::ensureAccessTokenAsync()
+{
+    if (hasValidAccessToken())
+        return readyFuture(true);
+
+    const auto promise = makePromise<bool>();
+
+    runOnClientThread([this, promise]
+    {
+        withAccessToken([promise](const bool valid) { fulfill(*promise, valid); });
+    });
+
+    return promise->future();
+}
+
+bool SpotifyApiClient::ensureAccessToken()
+{
+    const auto future = ensureAccessTokenAsync();
+    waitForAll({}, future);
+    return future.result();
+}
+
+void SpotifyApiClient::setAccessToken(const QString& token, const QDateTime& expiration)
+{
+    {
+        QMutexLocker locker(&tokenMutex);
+        accessToken = token;
+        expirationTime = expiration;
+    }
+
+    scheduleTokenRefresh();
+}
+
+void SpotifyApiClient::startTokenRefresh()
+{
+    if (isAccessTokenExpired())
+        refreshAccessTokenInBackground();
+    else
+        scheduleTokenRefresh();
+}
+
+QFuture<bool> SpotifyApiClient::refreshAccessTokenAsync()
+{
+    const auto promise = makePromise<bool>();
+
+    runOnClientThread([this, promise]
+    {
+        requestAccessToken([promise](const bool refreshed) { fulfill(*promise, refreshed); });
+    });
+
+    return promise->future();
+}
+
 bool SpotifyApiClient::refreshAccessToken()
 {
-    auto request = QNetworkRequest(QUrl(TOKEN_URL));
+    const auto future = refreshAccessTokenAsync();
+    waitForAll({}, future);
+    return future.result();
+}
 
-    const auto hash = QString("%1:%2").arg(clientId_, clientSecret_).toUtf8().toBase64();
-    const auto header = QString("Basic ").append(hash);
+void SpotifyApiClient::warmUpConnections()
+{
+    const auto now = QDateTime::currentMSecsSinceEpoch();
+    if (now - lastWarmUp < CONNECTION_WARMUP_INTERVAL)
+        return;
 
-    request.setRawHeader(QByteArray("Authorization"), header.toUtf8());
-    request.setHeader(QNetworkRequest::ContentTypeHeader, QVariant(QString("application/x-www-form-urlencoded")));
-    request.setTransferTimeout(DEFAULT_TIMEOUT);
+    lastWarmUp = now;
 
-    const auto savedToken = accessToken;
-    const auto postData = QString("grant_type=refresh_token&refresh_token=%1").arg(refreshToken_).toLocal8Bit();
-    const auto reply = network().post(request, postData);
+    // All requests are sent from the thread of the client, so its connection pool is the one to warm up.
+    runOnClientThread([]
+    {
+        for (const auto& url : {QUrl(API_URL), QUrl(ACCOUNTS_URL)})
+            if (url.scheme() == "https")
+                network().connectToHostEncrypted(url.host(), url.port(443));
 
-    connect(reply, &QNetworkReply::finished, this, [this, reply]
+        network().connectToHostEncrypted(IMAGES_HOST);
+    });
+}
+
+bool SpotifyApiClient::isServerUnreachable() const
+{
+    return reachability == Reachability::Offline
+           && QDateTime::currentMSecsSinceEpoch() - reachabilityTimestamp < REACHABILITY_OFFLINE_TTL;
+}
+
+void SpotifyApiClient::setMaxParallelDownloads(const int downloads) { maxParallelDownloads = downloads; }
+
+QFuture<void> SpotifyApiClient::downloadFilesAsync(const QHash<QString, QString>& files)
+{
+    // Existing files are skipped right away, without bothering the thread of the client.
+    QHash<QString, QString> missing;
+    for (auto it = files.cbegin(); it != files.cend(); ++it)
+        if (!it.value().isEmpty() && !QFileInfo::exists(it.key()))
+            missing.insert(it.key(), it.value());
+
+    const auto promise = makePromise<void>();
+
+    if (missing.isEmpty())
     {
-        reply->deleteLater();
+        promise->finish();
+        return promise->future();
+    }
 
-        const auto replyString = reply->readAll();
+    runOnClientThread([this, promise, missing]
+    {
+        const auto remaining = make_shared<qsizetype>(0);
+        const auto done = [promise, remaining]
+        {
+            if (--*remaining == 0)
+                promise->finish();
+        };
 
-        if (const auto jsonVariant = stringToJson(replyString); !jsonVariant["access_token"].isUndefined())
+        // Files being downloaded for another caller are skipped, they will appear once that finishes.
+        for (auto it = missing.cbegin(); it != missing.cend(); ++it)
         {
-            accessToken = jsonVariant["access_token"].toString();
-            expirationTime = QDateTime::currentDateTime().addSecs(jsonVariant["expires_in"].toInt());
-            lastErrorMessage = "";
+            if (downloads.contains(it.key()))
+                continue;
+
+            downloads.insert(it.key());
+            downloadQueue.append({it.key(), it.value(), isWantedBy(promise), done});
+            ++*remaining;
         }
+
+        if (*remaining == 0)
+            promise->finish();
         else
+            startDownloads();
+    });
+
+    return promise->future();
+}
+
+QFuture<SearchResults> SpotifyApiClient::searchAsync(const QString& query, const QStringList& types,
+                                                    const int limit, const int offset, const Lane lane)
+{
+    // Queries differing only in case or whitespace share one cache entry.
+    const auto typeList = types.join(',');
+    const auto cacheKey = QString("%1|%2|%3|%4").arg(query.simplified().toLower(), typeList).arg(limit).arg(offset);
+
+    if (const auto cached = searchCache.get(cacheKey))
+        return readyFuture(*cached);
+
+    const auto promise = makePromise<SearchResults>();
+    const auto url = QUrl(SEARCH_URL.arg(query, typeList, QString::number(limit), QString::number(offset)));
+
+    getCached(lane, url, isWantedBy(promise), [this, promise, cacheKey](const optional<CachedResponse>& response)
+    {
+        if (!response)
         {
-            accessToken = "";
-            lastErrorMessage = jsonVariant[
-                !jsonVariant["error_description"].isUndefined() ? "error_description" : "error"
-            ].toString();
+            fulfill(*promise, {});
+            return;
         }
-    });
 
-    waitForSignal(reply, SIGNAL(finished()));
+        const auto results = metrics_.measure("parse", [&] { return SearchParser::parse(response->body); });
+
+        // A stale body is revalidated in the background, keeping it in memory would hide the
+        // revalidated one for the whole time to live. The next search reads that one from disk.
+        if (!response->isStale)
+            searchCache.put(cacheKey, results);
+
+        fulfill(*promise, results);
+    });
 
-    return !accessToken.isEmpty() && savedToken != accessToken;
+    return promise->future();
 }
 
-bool SpotifyApiClient::checkServerResponse() const
+void SpotifyApiClient::fetch(const QString& url, function<void(const optional<QByteArray>&)> done)
 {
-    try
+    const auto absoluteUrl = QUrl(url.startsWith('/') ? API_URL + url : url);
+
+    withAccessToken([this, absoluteUrl, done](const bool valid)
     {
-        const auto request = QNetworkRequest(QUrl(TOKEN_URL));
-        const auto reply = network().get(request);
+        if (!valid)
+        {
+            done(nullopt);
+            return;
+        }
 
-        waitForSignal(reply, SIGNAL(finished()));
+        get(Lane::Prefetch, createRequest(absoluteUrl), {}, [done](const Response& response)
+        {
+            done(response.error == QNetworkReply::NoError ? optional(response.body) : nullopt);
+        });
+    });
+}
 
-        reply->deleteLater();
+void SpotifyApiClient::setSearchCacheSize(const int entries) { searchCache.setCapacity(entries); }
+
+void SpotifyApiClient::setSearchCacheTimeToLive(const int seconds)
+{
+    searchCache.setTimeToLive(seconds * 1000LL);
+    diskCacheFreshAge = seconds * 1000LL;
+}
+
+quint64 SpotifyApiClient::searchCacheHits() const { return searchCache.hits(); }
+
+quint64 SpotifyApiClient::searchCacheMisses() const { return searchCache.misses(); }
 
-        return reply->bytesAvailable();
+QFuture<QVector<Device>> SpotifyApiClient::getDevicesAsync()
+{
+    {
+        QMutexLocker locker(&devicesMutex);
+        if (devicesTimestamp.isValid() && devicesTimestamp.msecsTo(QDateTime::currentDateTime()) < DEVICES_CACHE_TTL)
+            return readyFuture(cachedDevices);
     }
-    catch (...)
+
+    const auto promise = makePromise<QVector<Device>>();
+
+    runOnClientThread([this, promise]
+    {
+        withAccessToken([this, promise](const bool valid)
+        {
+            if (!valid)
+            {
+                fulfill(*promise, {});
+                return;
+            }
+
+            ++deviceFetches;
+
+            get(Lane::Devices, createRequest(QUrl(DEVICES_URL)), isWantedBy(promise),
+                [this, promise](const Response& response)
+            {
+                // Do not cache results of aborted, failed or rate limited requests.
+                if (response.error != QNetworkReply::NoError)
+                {
+                    fulfill(*promise, {});
+                    return;
+                }
+
+                const auto devices = parseDevices(response.body);
+
+                {
+                    QMutexLocker locker(&devicesMutex);
+                    cachedDevices = devices;
+                    devicesTimestamp = QDateTime::currentDateTime();
+                }
+
+                fulfill(*promise, devices);
+            });
+        });
+    });
+
+    return promise->future();
+}
+
+QVector<Device> SpotifyApiClient::getDevices(const Validity& isValid)
+{
+    const auto future = getDevicesAsync();
+    return waitForAll(isValid, future) ? future.result() : QVector<Device>();
+}
+
+void SpotifyApiClient::invalidateDevices()
+{
+    QMutexLocker locker(&devicesMutex);
+    devicesTimestamp = QDateTime();
+}
+
+uint SpotifyApiClient::deviceFetchCount() const { return deviceFetches; }
+
+void SpotifyApiClient::waitForDevice(function<void(const QString& deviceId)> ready)
+{
+    // Polling goes through the devices lane, which paces it once the burst budget is spent.
+    get(Lane::Devices, createRequest(QUrl(DEVICES_URL)), {}, [this, ready](const Response& response)
     {
-        return false;
+        const auto devicesResult = stringToJson(response.body)["devices"].toArray();
+
+        if (devicesResult.isEmpty())
+        {
+            waitForDevice(ready);
+            return;
+        }
+
+        ready(devicesResult.at(0).toObject()["id"].toString());
+    });
+}
+
+void SpotifyApiClient::waitForDeviceAndPlay(const Track& track)
+{
+    waitForDevice([this, track](const QString& deviceId) { playTrack(track, deviceId); });
+}
+
+void SpotifyApiClient::waitForDeviceAndPlay(const Collection& collection)
+{
+    waitForDevice([this, collection](const QString& deviceId) { playCollection(collection, deviceId); });
+}
+
+void SpotifyApiClient::addTrackToQueue(const Track& track)
+{
+    const auto request = createRequest(QUrl(QUEUE_URL.arg(track.uri)));
+    observe(network().post(request, ""));
+}
+
+void SpotifyApiClient::playTrack(const Track& track, const QString& deviceId)
+{
+    // Playing on a device makes it the active one.
+    invalidateDevices();
+
+    const auto request = createRequest(QUrl(PLAY_URL.arg(deviceId)));
+    const auto postData = QString(R"({"uris": ["%1"]})").arg(track.uri).toLocal8Bit();
+    observe(network().put(request, postData));
+}
+
+void SpotifyApiClient::playCollection(const Collection& collection, const QString& deviceId)
+{
+    invalidateDevices();
+
+    // The play endpoint takes albums, artists and playlists as a context to play from its start.
+    const auto request = createRequest(QUrl(PLAY_URL.arg(deviceId)));
+    const auto postData = QString(R"({"context_uri": "%1"})").arg(collection.uri).toUtf8();
+    observe(network().put(request, postData));
+}
+
+// PRIVATE METHODS
+
+SpotifyApiClient::Waiter::Waiter(Validity isValid):
+    isValid(std::move(isValid))
+{
+}
+
+void SpotifyApiClient::Waiter::watch(unique_ptr<QFutureWatcherBase> watcher)
+{
+    ++pending;
+
+    QObject::connect(watcher.get(), &QFutureWatcherBase::finished, &loop, [this]
+    {
+        if (--pending == 0)
+            loop.quit();
+    });
+
+    watchers.push_back(std::move(watcher));
+}
+
+bool SpotifyApiClient::Waiter::wait()
+{
+    if (ranges::all_of(watchers, [](const auto& watcher) { return watcher->isFinished(); }))
+        return true;
+
+    bool valid = true;
+
+    QTimer validityTimer;
+    if (isValid)
+    {
+        QObject::connect(&validityTimer, &QTimer::timeout, &loop, [&]
+        {
+            if (isValid())
+                return;
+
+            valid = false;
+            for (const auto& watcher : watchers)
+                watcher->cancel();
+            loop.quit();
+        });
+        validityTimer.start(VALIDITY_POLL_INTERVAL);
     }
+
+    loop.exec();
+
+    return valid;
 }
 
-void SpotifyApiClient::downloadFile(const QString& url, const QString& filePath)
+void SpotifyApiClient::runOnClientThread(const function<void()>& function)
 {
-    if (const QFileInfo fileInfo(filePath); fileInfo.exists())
-        return;
+    if (QThread::currentThread() == thread())
+        function();
+    else
+        QMetaObject::invokeMethod(this, function, Qt::QueuedConnection);
+}
+
+void SpotifyApiClient::setReachability(const Reachability state)
+{
+    reachability = state;
+    reachabilityTimestamp = QDateTime::currentMSecsSinceEpoch();
+}
 
+QNetworkReply* SpotifyApiClient::observe(QNetworkReply* reply)
+{
+    // The encrypted signal is only emitted if a new TLS handshake was necessary,
+    // replies on warmed-up connections spend all their time on the transfer.
+    const auto timer = make_shared<QElapsedTimer>();
+    const auto handshake = make_shared<qint64>(0);
+    timer->start();
 
-    const auto request = QNetworkRequest(url);
-    const auto reply = network().get(request);
+    connect(reply, &QNetworkReply::encrypted, reply, [timer, handshake]
+    {
+        *handshake = timer->elapsed();
+    });
 
-    connect(reply, &QNetworkReply::finished, this, [this, reply, filePath]
+    connect(reply, &QNetworkReply::finished, reply, [this, reply, timer, handshake]
     {
-        reply->deleteLater();
+        if (reply->error() == QNetworkReply::OperationCanceledError)
+        {
+            ++cancelledRequests;
+            return;
+        }
+
+        ++completedRequests;
 
-        fileLock.lockForWrite();
+        DEBG << QString("%1%2: handshake %3 ms, transfer %4 ms")
+                    .arg(reply->url().host(), reply->url().path())
+                    .arg(*handshake)
+                    .arg(timer->elapsed() - *handshake);
 
-        if (reply->bytesAvailable())
+        if (metrics_.isEnabled())
         {
-            QSaveFile file(filePath);
-            file.open(QIODevice::WriteOnly);
-            file.write(reply->readAll());
-            file.commit();
+            // Image paths are unique per cover, so they are accounted as one endpoint.
+            const auto endpoint = reply->url().host() == IMAGES_HOST ? QString("images") : reply->url().path();
+            metrics_.recordRequest(endpoint, reply->bytesAvailable(), timer->elapsed());
+            if (*handshake)
+                metrics_.recordStage("tls handshake", *handshake);
         }
 
-        fileLock.unlock();
+        // Any HTTP status, even an error one, means the server answered.
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).isValid())
+            setReachability(Reachability::Online);
+        else
+            setReachability(Reachability::Offline);
     });
 
-    waitForSignal(reply, SIGNAL(finished()));
-
+    return reply;
 }
 
-QVector<Track> SpotifyApiClient::searchTracks(const QString& query, const int limit)
+void SpotifyApiClient::get(const Lane lane, const QNetworkRequest& request, Validity isWanted,
+                           function<void(const Response&)> done)
 {
-    const auto url = QUrl(SEARCH_URL.arg(query, "track", QString::number(limit)));
-    const auto request = createRequest(url);
-    const auto reply = network().get(request);
+    const auto key = QString("%1|%2|%3").arg(request.url().toString(),
+                                             QString::fromUtf8(request.rawHeader("Authorization")),
+                                             QString::fromUtf8(request.rawHeader("If-None-Match")));
 
-    auto tracksArray = make_shared<QJsonArray>();
+    auto flight = flights.value(key);
 
-    connect(reply, &QNetworkReply::finished, [reply, tracksArray]
+    if (flight)
     {
-        reply->deleteLater();
+        ++coalescedRequests;
+        flight->requesters.append({std::move(isWanted), std::move(done)});
+
+        // A queued flight moves to the lane of a more urgent requester, e.g. a search typed
+        // while its prefetch still waits, the send queued in the old lane is skipped then.
+        if (flight->reply || lane >= flight->lane)
+            return;
+    }
+    else
+    {
+        flight = make_shared<Flight>();
+        flight->requesters.append({std::move(isWanted), std::move(done)});
+        flights.insert(key, flight);
+    }
+
+    flight->lane = lane;
+
+    // Queued flights join new requesters as well, the request is sent once for all of them.
+    scheduler.schedule(lane, [this, lane, request, flight, key]
+    {
+        // Dropped or moved to another lane while waiting in the queue.
+        if (flights.value(key) != flight || flight->reply || flight->lane != lane)
+            return false;
+
+        const auto reply = observe(network().get(request));
+        flight->reply = reply;
+
+        // Fan the result out to all requesters as soon as it arrives.
+        connect(reply, &QNetworkReply::finished, this, [this, lane, reply, flight, key]
+        {
+            observeRateLimit(lane, reply);
+            const auto response = toResponse(reply);
+            reply->deleteLater();
+
+            if (flights.value(key) == flight)
+                flights.remove(key);
 
-        const auto jsonObject = stringToJson(reply->readAll());
+            for (const auto& requester : as_const(flight->requesters))
+                requester.done(response);
+        });
 
-        *tracksArray = jsonObject["tracks"].toObject()["items"].toArray();
+        return true;
     });
 
-    waitForSignal(reply, SIGNAL(finished()));
+    if (!cancellationTimer.isActive())
+        cancellationTimer.start();
+}
 
-    const auto tracks = make_shared<QVector<Track>>();
+void SpotifyApiClient::dropUnwantedRequests()
+{
+    QList<QPointer<QNetworkReply>> unwanted;
 
-    for (const auto &trackData : as_const(*tracksArray))
+    for (auto it = flights.begin(); it != flights.end();)
     {
-        tracks->append(parseTrack(trackData.toObject()));
+        const auto& flight = it.value();
+
+        flight->requesters.removeIf([](const Requester& requester)
+        {
+            return requester.isWanted && !requester.isWanted();
+        });
+
+        // Flights still queued in the scheduler have no reply, the scheduler skips them once they are gone.
+        if (flight->requesters.isEmpty() && !flight->reply)
+        {
+            ++cancelledRequests;
+            it = flights.erase(it);
+            continue;
+        }
+
+        if (flight->requesters.isEmpty())
+            unwanted.append(flight->reply);
+
+        ++it;
     }
 
-    return *tracks;
+    // Aborting finishes the reply right away, which removes its flight.
+    for (const auto& reply : as_const(unwanted))
+        if (reply && reply->isRunning())
+            reply->abort();
+
+    if (flights.isEmpty())
+        cancellationTimer.stop();
+}
+
+void SpotifyApiClient::startDownloads()
+{
+    while (runningDownloads < max(maxParallelDownloads.load(), 1) && !downloadQueue.isEmpty())
+    {
+        const auto download = downloadQueue.takeFirst();
+
+        // Nobody waits for the file anymore, e.g. the query was superseded.
+        if (!download.isWanted())
+        {
+            downloads.remove(download.filePath);
+            download.done();
+            continue;
+        }
+
+        ++runningDownloads;
+
+        const auto finish = [this, download]
+        {
+            downloads.remove(download.filePath);
+            --runningDownloads;
+            download.done();
+
+            startDownloads();
+        };
+
+        // The slot is held while the download waits for its turn in the covers lane.
+        scheduler.schedule(Lane::Covers, [this, download, finish]
+        {
+            if (!download.isWanted())
+            {
+                finish();
+                return false;
+            }
+
+            auto request = QNetworkRequest(QUrl(download.url));
+            request.setTransferTimeout(DEFAULT_TIMEOUT);
+            const auto reply = observe(network().get(request));
+
+            // Started downloads always complete, the file is useful to later queries as well.
+            connect(reply, &QNetworkReply::finished, this, [this, reply, download, finish]
+            {
+                observeRateLimit(Lane::Covers, reply);
+                saveReply(reply, download.filePath);
+                reply->deleteLater();
+                finish();
+            });
+
+            return true;
+        });
+    }
 }
 
-QVector<Device> SpotifyApiClient::getDevices()
+SpotifyApiClient::Response SpotifyApiClient::toResponse(QNetworkReply* reply)
 {
-    const auto request = createRequest(QUrl(DEVICES_URL));
-    const auto reply = network().get(request);
+    return {
+        .status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(),
+        .error = reply->error(),
+        .body = reply->readAll(),
+        .etag = reply->rawHeader("ETag")
+    };
+}
 
-    auto devicesArray = make_shared<QJsonArray>();
+void SpotifyApiClient::observeRateLimit(const Lane lane, QNetworkReply* reply)
+{
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() != 429)
+        return;
+
+    // Retry-After holds seconds, the HTTP date form is not used by Spotify.
+    bool ok = false;
+    const auto seconds = reply->rawHeader("Retry-After").trimmed().toLongLong(&ok);
+    const auto delay = ok && seconds >= 0 ? seconds * 1000 : DEFAULT_RETRY_AFTER;
+
+    WARN << QString("Rate limited by %1%2, retrying after %3 ms")
+                .arg(reply->url().host(), reply->url().path())
+                .arg(delay);
+
+    scheduler.pause(lane, delay);
+    metrics_.increment("rate limited");
+}
 
-    connect(reply, &QNetworkReply::finished, [reply, devicesArray]
+void SpotifyApiClient::saveReply(QNetworkReply* reply, const QString& filePath)
+{
+    if (reply->error() != QNetworkReply::NoError || !reply->bytesAvailable())
+        return;
+
+    QWriteLocker locker(&fileLock);
+
+    QSaveFile file(filePath);
+    if (file.open(QIODevice::WriteOnly))
     {
-        reply->deleteLater();
+        const auto size = file.write(reply->readAll());
+
+        if (file.commit())
+            emit fileDownloaded(filePath, size);
+    }
+}
+
+void SpotifyApiClient::getCached(const Lane lane, const QUrl& url, Validity isWanted,
+                                 function<void(const optional<CachedResponse>&)> done)
+{
+    const auto entry = diskCache.load(url.toString());
+
+    if (entry)
+    {
+        const auto age = QDateTime::currentMSecsSinceEpoch() - entry->timestamp;
+
+        if (age < diskCacheFreshAge)
+        {
+            done(CachedResponse{entry->body, false});
+            return;
+        }
+
+        if (age < DISK_CACHE_STALE_AGE)
+        {
+            revalidateInBackground(url);
+            done(CachedResponse{entry->body, true});
+            return;
+        }
+    }
 
-        QJsonObject jsonObject = stringToJson(reply->readAll());
+    runOnClientThread([this, lane, url, entry, isWanted, done]
+    {
+        withAccessToken([this, lane, url, entry, isWanted, done](const bool valid)
+        {
+            if (!valid)
+            {
+                done(nullopt);
+                return;
+            }
+
+            get(lane, createCacheRequest(url, entry), isWanted, [this, url, entry, done](const Response& response)
+            {
+                if (const auto body = storeResponse(url.toString(), response, entry))
+                    done(CachedResponse{*body, false});
+                else
+                    done(nullopt);
+            });
+        });
+    });
+}
 
-        *devicesArray = jsonObject["devices"].toArray();
+void SpotifyApiClient::revalidateInBackground(const QUrl& url)
+{
+    // The query thread does not process events once the query is done,
+    // so the revalidation runs on the thread of the client instead.
+    runOnClientThread([this, url]
+    {
+        if (revalidations.contains(url.toString()))
+            return;
+
+        revalidations.insert(url.toString());
+
+        // Requests with an expired token would only fail with 401, so it is refreshed first.
+        withAccessToken([this, url](const bool valid)
+        {
+            if (!valid)
+            {
+                revalidations.remove(url.toString());
+                return;
+            }
+
+            const auto entry = diskCache.load(url.toString());
+
+            get(Lane::Prefetch, createCacheRequest(url, entry), {}, [this, url, entry](const Response& response)
+            {
+                storeResponse(url.toString(), response, entry);
+                revalidations.remove(url.toString());
+            });
+        });
     });
+}
 
-    waitForSignal(reply, SIGNAL(finished()));
+QNetworkRequest SpotifyApiClient::createCacheRequest(const QUrl& url,
+                                                     const optional<HttpDiskCache::Entry>& entry) const
+{
+    auto request = createRequest(url);
+
+    if (entry && !entry->etag.isEmpty())
+        request.setRawHeader(QByteArray("If-None-Match"), entry->etag);
 
-    const auto devices = make_shared<QVector<Device>>();
+    return request;
+}
 
-    for (auto deviceData : as_const(*devicesArray))
+optional<QByteArray> SpotifyApiClient::storeResponse(const QString& key, const Response& response,
+                                                     const optional<HttpDiskCache::Entry>& entry)
+{
+    // Not modified, the cached body is still valid.
+    if (response.status == 304 && entry)
     {
-        devices->append(parseDevice(deviceData.toObject()));
+        auto revalidated = *entry;
+        revalidated.timestamp = QDateTime::currentMSecsSinceEpoch();
+        diskCache.store(key, revalidated);
+        return revalidated.body;
     }
 
-    return *devices;
+    if (response.error != QNetworkReply::NoError)
+        return nullopt;
+
+    HttpDiskCache::Entry fresh;
+    fresh.body = response.body;
+    fresh.etag = response.etag;
+    fresh.timestamp = QDateTime::currentMSecsSinceEpoch();
+    diskCache.store(key, fresh);
+
+    return fresh.body;
+}
+
+QJsonObject SpotifyApiClient::stringToJson(const QString& string)
+{
+    return QJsonDocument::fromJson(string.toUtf8()).object();
+}
+
+bool SpotifyApiClient::hasValidAccessToken() const
+{
+    QMutexLocker locker(&tokenMutex);
+    return !accessToken.isEmpty() && QDateTime::currentDateTime() < expirationTime;
+}
+
+void SpotifyApiClient::withAccessToken(function<void(bool)> done)
+{
+    if (hasValidAccessToken())
+        done(true);
+    // The server rejected the credentials, asking again before they change would only fail again.
+    else if (credentialsRejected)
+        done(false);
+    else
+        requestAccessToken(std::move(done));
 }
 
-void SpotifyApiClient::waitForDevice(const Track& track)
+void SpotifyApiClient::requestAccessToken(function<void(bool)> done)
 {
-    const auto request = createRequest(QUrl(DEVICES_URL));
-    const auto reply = network().get(request);
+    if (done)
+        tokenWaiters.append(std::move(done));
 
-    connect(reply, &QNetworkReply::finished, this, [this, reply, track]
+    // Somebody else is refreshing already, share their result instead of sending another request.
+    if (tokenRefreshing)
+        return;
+
+    tokenRefreshing = true;
+    const auto reply = observe(network().post(createTokenRequest(), createTokenRequestData()));
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply]
     {
+        const auto refreshed = applyTokenReply(reply);
+        const auto retry = !refreshed && isTransientFailure(reply);
         reply->deleteLater();
 
-        const auto jsonObject = stringToJson(reply->readAll());
-        const auto devicesResult = jsonObject["devices"].toArray();
+        tokenRefreshing = false;
 
-        if (devicesResult.isEmpty())
+        // A successful refresh schedules the next one. Network and server failures are retried
+        // with backoff, rejected credentials would only be rejected again until they are changed.
+        if (retry)
         {
-            waitForDevice(track);
-            return;
+            tokenRefreshTimer.start(tokenRetryDelay);
+            tokenRetryDelay = min(tokenRetryDelay * 2, TOKEN_RETRY_MAX_DELAY);
         }
 
-        emit deviceReady(track, devicesResult.at(0).toObject()["id"].toString());
+        for (const auto& waiter : std::exchange(tokenWaiters, {}))
+            waiter(refreshed);
     });
 }
 
-void SpotifyApiClient::waitForDeviceAndPlay(const Track& track)
+void SpotifyApiClient::scheduleTokenRefresh()
 {
-    connect(this, &SpotifyApiClient::deviceReady, this, &SpotifyApiClient::playTrack);
-    waitForDevice(track);
+    QDateTime expiration;
+    {
+        QMutexLocker locker(&tokenMutex);
+        expiration = expirationTime;
+    }
+
+    if (!expiration.isValid())
+        return;
+
+    // Jitter keeps multiple instances from hitting the accounts endpoint at the same moment.
+    const auto jitter = QRandomGenerator::global()->bounded(TOKEN_REFRESH_JITTER);
+    const auto delay = QDateTime::currentDateTime().msecsTo(expiration) - TOKEN_REFRESH_MARGIN - jitter;
+
+    tokenRetryDelay = TOKEN_RETRY_MIN_DELAY;
+    tokenRefreshTimer.start(static_cast<int>(max<qint64>(delay, 0)));
 }
 
-void SpotifyApiClient::addTrackToQueue(const Track& track) const
+void SpotifyApiClient::refreshAccessTokenInBackground()
 {
-    const auto request = createRequest(QUrl(QUEUE_URL.arg(track.uri)));
-    network().post(request, "");
+    if (refreshToken_.isEmpty())
+        return;
+
+    requestAccessToken({});
 }
 
-void SpotifyApiClient::playTrack(const Track& track, const QString& deviceId) const
+bool SpotifyApiClient::applyTokenReply(QNetworkReply* reply)
 {
-    const auto request = createRequest(QUrl(PLAY_URL.arg(deviceId)));
-    const auto postData = QString(R"({"uris": ["%1"]})").arg(track.uri).toLocal8Bit();
-    network().put(request, postData);
+    const auto jsonVariant = stringToJson(reply->readAll());
+
+    QMutexLocker locker(&tokenMutex);
+
+    if (!jsonVariant["access_token"].isUndefined())
+    {
+        accessToken = jsonVariant["access_token"].toString();
+        expirationTime = QDateTime::currentDateTime().addSecs(jsonVariant["expires_in"].toInt());
+        lastErrorMessage = "";
+        credentialsRejected = false;
+
+        const auto token = accessToken;
+        const auto expiration = expirationTime;
+        locker.unlock();
+
+        emit accessTokenChanged(token, expiration);
+        scheduleTokenRefresh();
+        return true;
+    }
+
+    // Keep a still valid token on network failures, drop it only if the server refused.
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).isValid())
+        accessToken = "";
+
+    credentialsRejected = !isTransientFailure(reply);
+
+    lastErrorMessage = jsonVariant[
+        !jsonVariant["error_description"].isUndefined() ? "error_description" : "error"
+    ].toString();
+
+    return false;
 }
 
-// PRIVATE METHODS
+bool SpotifyApiClient::isTransientFailure(QNetworkReply* reply)
+{
+    const auto status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+    return !status.isValid() || status.toInt() >= 500;
+}
 
-void SpotifyApiClient::waitForSignal(const QObject* sender, const char* signal)
+QNetworkRequest SpotifyApiClient::createTokenRequest() const
 {
-    QEventLoop loop;
-    connect(sender, signal, &loop, SLOT(quit()));
-    loop.exec();
+    auto request = QNetworkRequest(QUrl(TOKEN_URL));
+
+    const auto hash = QString("%1:%2").arg(clientId_, clientSecret_).toUtf8().toBase64();
+    const auto header = QString("Basic ").append(hash);
+
+    request.setRawHeader(QByteArray("Authorization"), header.toUtf8());
+    request.setHeader(QNetworkRequest::ContentTypeHeader, QVariant(QString("application/x-www-form-urlencoded")));
+    request.setTransferTimeout(DEFAULT_TIMEOUT);
+
+    return request;
 }
 
-QJsonObject SpotifyApiClient::stringToJson(const QString& string)
+QByteArray SpotifyApiClient::createTokenRequestData() const
 {
-    return QJsonDocument::fromJson(string.toUtf8()).object();
+    return QString("grant_type=refresh_token&refresh_token=%1").arg(refreshToken_).toLocal8Bit();
 }
 
 QNetworkRequest SpotifyApiClient::createRequest(const QUrl& url) const
 {
     const auto request = make_shared<QNetworkRequest>(url);
+
+    QMutexLocker locker(&tokenMutex);
     const auto header = QString("Bearer ") + accessToken;
+    locker.unlock();
 
     request->setRawHeader(QByteArray("Authorization"), header.toUtf8());
     request->setRawHeader(QByteArray("Accept"), "application/json");
@@ -260,6 +1047,21 @@ QNetworkRequest SpotifyApiClient::createRequest(const QUrl& url) const
     return *request;
 }
 
+QVector<Device> SpotifyApiClient::parseDevices(const QByteArray& json)
+{
+    const auto devicesArray = stringToJson(json)["devices"].toArray();
+
+    QVector<Device> devices;
+    devices.reserve(devicesArray.size());
+
+    for (const auto &deviceData : devicesArray)
+    {
+        devices.append(parseDevice(deviceData.toObject()));
+    }
+
+    return devices;
+}
+
 Device SpotifyApiClient::parseDevice(QJsonObject deviceData)
 {
     auto device = Device();
@@ -271,28 +1073,3 @@ Device SpotifyApiClient::parseDevice(QJsonObject deviceData)
 
     return device;
 }
-
-Track SpotifyApiClient::parseTrack(QJsonObject trackData)
-{
-    auto track = Track();
-
-    track.id = trackData["id"].toString();
-    track.name = trackData["name"].toString();
-    track.artists = linearizeArtists(trackData["artists"].toArray());
-    track.albumId = trackData["album"].toObject()["id"].toString();
-    track.albumName = trackData["album"].toObject()["name"].toString();
-    track.uri = trackData["uri"].toString();
-    track.imageUrl = trackData["album"].toObject()["images"].toArray()[2].toObject()["url"].toString();
-    track.isExplicit = trackData["explicit"].toBool();
-
-    return track;
-}
-
-QString SpotifyApiClient::linearizeArtists(const QJsonArray& artists)
-{
-    QStringList linearizedArtists;
-    ranges::transform(artists, back_inserter(linearizedArtists),
-                      [](const QJsonValue& artist){ return artist["name"].toString(); });
-
-    return linearizedArtists.join(", ");
-}
@@ -1,23 +1,55 @@
 // Copyright (c) 2020-2025 Ivo Šmerek
 
 #pragma once
+#include "httpDiskCache.h"
+#include "lruCache.h"
+#include "metrics.h"
+#include "requestScheduler.h"
 #include "types/device.h"
-#include "types/track.h"
+#include "types/searchResults.h"
 #include <QDateTime>
+#include <QEventLoop>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QMutex>
+#include <QNetworkReply>
+#include <QNetworkRequest>
 #include <QObject>
+#include <QPointer>
 #include <QReadWriteLock>
-class QNetworkRequest;
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
 
 
 
 /**
  * Spotify API client for interacting with the Spotify Web API.
+ *
+ * All network I/O runs on the thread of the client, which always processes events.
+ * The asynchronous methods may be called from any thread and return futures, so a caller
+ * can issue several requests at once and wait for all of them with a single waitForAll.
+ * The synchronous methods are thin wrappers waiting for the asynchronous ones.
  */
 class SpotifyApiClient final : public QObject
 {
 public:
     explicit SpotifyApiClient(QString clientId, QString clientSecret, QString refreshToken);
 
+    /**
+     * Predicate telling whether the caller is still interested in the result of a request.
+     * Requests are aborted as soon as it returns false.
+     */
+    using Validity = std::function<bool()>;
+
+    using Lane = RequestScheduler::Lane;
+
     /** Contains string description of the last error message. */
     QString lastErrorMessage;
 
@@ -30,52 +62,209 @@ public:
     QString refreshToken();
     void setRefreshToken(const QString& token);
 
+    /**
+     * Set directory where API responses are persisted across restarts.
+     * @param path Path to the directory, an empty path disables the disk cache.
+     */
+    void setCacheDirectory(const QString& path);
+
     /**
      * Check if the access token is expired.
      * @return true if the access token is expired, false otherwise.
      */
     bool isAccessTokenExpired() const;
 
+    /**
+     * Wait for all futures to finish, processing events of the calling thread meanwhile.
+     * @param isValid Cancel the futures and stop waiting once this returns false.
+     * @param futures The futures to wait for.
+     * @return false if waiting was given up, true if all futures finished.
+     */
+    template<typename... T>
+    static bool waitForAll(const Validity& isValid, const QFuture<T>&... futures)
+    {
+        Waiter waiter(isValid);
+        (waiter.add(futures), ...);
+        return waiter.wait();
+    }
+
     // WEB API CALLS //
 
+    /**
+     * Make sure there is a valid access token, refreshing it if needed.
+     * Concurrent callers finding an expired token share a single refresh.
+     * Tokens are normally refreshed in the background ahead of their expiration,
+     * so this only sends a request if the background refresh did not succeed.
+     * Once the server rejected the credentials, no request is sent until they change.
+     * @return Future of true if there is a valid access token.
+     */
+    QFuture<bool> ensureAccessTokenAsync();
+
+    /**
+     * Synchronous version of ensureAccessTokenAsync.
+     */
+    bool ensureAccessToken();
+
+    /**
+     * Restore a previously obtained access token, e.g. one persisted across restarts.
+     * @param token The access token.
+     * @param expiration Time when the access token expires.
+     */
+    void setAccessToken(const QString& token, const QDateTime& expiration);
+
+    /**
+     * Start keeping the access token fresh in the background.
+     * A missing or expired token is requested right away without blocking.
+     */
+    void startTokenRefresh();
+
     /**
      * Request and store a new access token from Spotify.
-     * @return true if the accessToken was successfully refreshed.
+     * @return Future of true if the accessToken was successfully refreshed.
+     */
+    QFuture<bool> refreshAccessTokenAsync();
+
+    /**
+     * Synchronous version of refreshAccessTokenAsync.
      */
     bool refreshAccessToken();
 
     /**
-     * Check response of Spotify API server.
-     * @return true if server returns any response, false otherwise.
+     * Open encrypted connections to the API, accounts and image hosts ahead of time,
+     * so the following requests skip DNS, TCP and TLS setup.
+     * Repeated calls within a short interval are no-ops.
+     */
+    void warmUpConnections();
+
+    /**
+     * Check whether the Spotify API server is known to be unreachable.
+     * The verdict is learned from outcomes of regular API calls and network change
+     * notifications and cached for a short time, it never sends a request.
+     * @return true if the server recently turned out to be unreachable.
      */
-    bool checkServerResponse() const;
+    bool isServerUnreachable() const;
 
     /**
-     * Download a file from the given URL and save it to the given file path.
-     * It will not download the file if the given pilePath already exists.
-     * @param url URL to download.
-     * @param filePath File path to save the file to.
+     * Set maximum number of downloads running at the same time.
      */
-    void downloadFile(const QString& url, const QString& filePath);
+    void setMaxParallelDownloads(int downloads);
 
     /**
-     * Search for tracks on Spotify.
+     * Download multiple files concurrently and save them to the given file paths.
+     * Files that already exist are skipped, so each path is fetched at most once.
+     * Downloads that did not start before the future was cancelled are dropped.
+     * @param files File paths mapped to URLs they should be downloaded from.
+     * @return Future finishing once all files are downloaded.
+     */
+    QFuture<void> downloadFilesAsync(const QHash<QString, QString>& files);
+
+    /**
+     * Search Spotify for several result types at once, all of them in a single request.
      * @param query The search query.
-     * @param limit The maximum number of tracks to return.
-     * @return A list of tracks found by the search.
+     * @param types Result types to search for, e.g. track, album, artist and playlist.
+     * @param limit The maximum number of results of each type.
+     * @param offset Index of the first result of each type, to fetch further pages.
+     * @param lane The lane of the scheduler to send the request in, e.g. prefetch for speculative searches.
+     * @return Future of the results found by the search.
+     */
+    QFuture<SearchResults> searchAsync(const QString& query, const QStringList& types, int limit, int offset = 0,
+                                       Lane lane = Lane::Search);
+
+    /**
+     * Send an authorized GET request to the Web API without waiting for the response.
+     * Must be called on the thread of the client.
+     * @param url Absolute URL or path relative to the Web API base URL.
+     * @param done Called with the response body or nothing if the request failed.
+     */
+    void fetch(const QString& url, std::function<void(const std::optional<QByteArray>&)> done);
+
+    /**
+     * Set maximum number of cached search results, zero disables the cache.
+     */
+    void setSearchCacheSize(int entries);
+
+    /**
+     * Set maximum age of cached search results in seconds.
+     * Responses cached on disk are used without revalidation for the same time.
+     */
+    void setSearchCacheTimeToLive(int seconds);
+
+    /**
+     * Returns number of searches answered from the cache.
+     */
+    quint64 searchCacheHits() const;
+
+    /**
+     * Returns number of searches that had to be sent to the server.
      */
-    QVector<Track> searchTracks(const QString& query, int limit);
+    quint64 searchCacheMisses() const;
 
     /**
      * Returns list of users available Spotify devices.
+     * The list is served from a short-lived cache shared by all callers.
+     * @return Future of the devices.
+     */
+    QFuture<QVector<Device>> getDevicesAsync();
+
+    /**
+     * Synchronous version of getDevicesAsync.
+     * @param isValid Abort the request once this returns false.
+     */
+    QVector<Device> getDevices(const Validity& isValid = {});
+
+    /**
+     * Parse a device list response of the Web API.
+     * @param json The raw response body.
+     * @return The devices, empty if the response is malformed.
+     */
+    static QVector<Device> parseDevices(const QByteArray& json);
+
+    /**
+     * Drop the cached list of devices, e.g. when the active device changed.
      */
-    QVector<Device> getDevices();
+    void invalidateDevices();
 
     /**
-     * Wait for any device to be ready.
-     * @param track
+     * Returns number of device list requests sent to the server.
      */
-    void waitForDevice(const Track& track);
+    uint deviceFetchCount() const;
+
+    /**
+     * Returns number of requests aborted because their results were no longer needed.
+     */
+    quint64 cancelledRequestCount() const;
+
+    /**
+     * Returns number of requests that ran to completion, successfully or not.
+     */
+    quint64 completedRequestCount() const;
+
+    /**
+     * Returns number of requests answered by joining an identical request in flight.
+     */
+    quint64 coalescedRequestCount() const;
+
+    /**
+     * Returns milliseconds until requests of the lane are sent again after the server
+     * answered 429 Too Many Requests, zero if the lane is not rate limited.
+     */
+    qint64 rateLimitedFor(Lane lane) const;
+
+    /**
+     * Returns statistics of requests and stages of this client and its users.
+     */
+    Metrics& metrics();
+
+    /**
+     * Returns human-readable summary of the statistics and counters of this client.
+     */
+    QString statisticsSummary() const;
+
+    /**
+     * Wait for any device to be ready and call a function with it.
+     * @param ready Called with the ID of the first device.
+     */
+    void waitForDevice(std::function<void(const QString& deviceId)> ready);
 
     /**
      * Wait for any device to be ready and play a track on it.
@@ -83,11 +272,17 @@ public:
      */
     void waitForDeviceAndPlay(const Track& track);
 
+    /**
+     * Wait for any device to be ready and play an album, artist or playlist on it.
+     * @param collection The collection to play.
+     */
+    void waitForDeviceAndPlay(const Collection& collection);
+
     /**
      * Add a track to the queue of a specific device.
      * @param track The track object to add to the queue.
      */
-    void addTrackToQueue(const Track& track) const;
+    void addTrackToQueue(const Track& track);
 
    public slots:
     /**
@@ -95,11 +290,58 @@ public:
      * @param track The track object to play.
      * @param deviceId The ID of the device to play the track on.
      */
-    void playTrack(const Track& track, const QString& deviceId) const;
+    void playTrack(const Track& track, const QString& deviceId);
+
+    /**
+     * Play an album, artist or playlist from its start on a specific device.
+     * @param collection The collection to play.
+     * @param deviceId The ID of the device to play the collection on.
+     */
+    void playCollection(const Collection& collection, const QString& deviceId);
 
 private:
     Q_OBJECT
 
+    struct Response
+    {
+        int status = 0;
+        QNetworkReply::NetworkError error = QNetworkReply::NoError;
+        QByteArray body;
+        QByteArray etag;
+    };
+
+    /**
+     * Waits for futures in a local event loop of the calling thread.
+     */
+    class Waiter
+    {
+    public:
+        explicit Waiter(Validity isValid);
+
+        template<typename T>
+        void add(const QFuture<T>& future)
+        {
+            auto watcher = std::make_unique<QFutureWatcher<T>>();
+            const auto raw = watcher.get();
+            watch(std::move(watcher));
+            raw->setFuture(future);
+        }
+
+        /**
+         * Wait until all futures finish or the caller loses interest.
+         * @return false if the futures were cancelled because the caller lost interest.
+         */
+        bool wait();
+
+    private:
+        void watch(std::unique_ptr<QFutureWatcherBase> watcher);
+
+        Validity isValid;
+        QEventLoop loop;
+        int pending = 0;
+        std::vector<std::unique_ptr<QFutureWatcherBase>> watchers;
+    };
+
     QString clientId_;
     QString clientSecret_;
     QString refreshToken_;
@@ -108,12 +350,237 @@ private:
     QDateTime expirationTime;
     QReadWriteLock fileLock;
 
+    mutable QMutex tokenMutex;  // Guards accessToken and expirationTime
+    bool tokenRefreshing = false;
+    std::atomic<bool> credentialsRejected = false;  // Reset once the credentials change
+    QList<std::function<void(bool)>> tokenWaiters;
+    QTimer tokenRefreshTimer;
+    int tokenRetryDelay;
+
+    /**
+     * Returns true if there is an access token that did not expire yet.
+     */
+    bool hasValidAccessToken() const;
+
+    /**
+     * Run a function once there is a valid access token, refreshing it if needed.
+     * Must be called on the thread of the client.
+     * @param done Called with true if there is a valid access token.
+     */
+    void withAccessToken(std::function<void(bool)> done);
+
+    /**
+     * Request a new access token, joining a refresh in flight.
+     * Refreshes failed by the network or the server are retried in the background
+     * with exponential backoff, rejected credentials are not retried.
+     * Must be called on the thread of the client.
+     * @param done Called with true if a new access token was received, may be empty.
+     */
+    void requestAccessToken(std::function<void(bool)> done);
+
+    /**
+     * Schedule a background refresh of the access token ahead of its expiration.
+     */
+    void scheduleTokenRefresh();
+
+    /**
+     * Refresh the access token in the background if there is a refresh token.
+     */
+    void refreshAccessTokenInBackground();
+
+    /**
+     * Store the access token from a finished token reply.
+     * @param reply The finished reply of the accounts endpoint.
+     * @return true if a new access token was received.
+     */
+    bool applyTokenReply(QNetworkReply* reply);
+
+    /**
+     * Check whether a failed reply may succeed when sent again.
+     * @param reply The finished reply.
+     * @return true if the server did not answer or failed itself, false if it rejected the request.
+     */
+    static bool isTransientFailure(QNetworkReply* reply);
+
+    /**
+     * Create a request for a new access token authorized by the client credentials.
+     */
+    QNetworkRequest createTokenRequest() const;
+
+    /**
+     * Create form data of the access token request containing the refresh token.
+     */
+    QByteArray createTokenRequestData() const;
+
+    Metrics metrics_;
+    LruCache<QString, SearchResults> searchCache;
+    HttpDiskCache diskCache;
+    std::atomic<qint64> diskCacheFreshAge;  // Milliseconds a cached response is used without revalidation
+
+    QSet<QString> revalidations;
+
+    /**
+     * Response body read through the disk cache.
+     */
+    struct CachedResponse
+    {
+        QByteArray body;
+        bool isStale;  // The body is outdated and being revalidated in the background
+    };
+
+    /**
+     * Fetch a resource through the disk cache.
+     * Fresh entries are returned without any request, stale entries are returned immediately
+     * and revalidated in the background. Missing or outdated entries are requested with
+     * If-None-Match, so an unchanged resource costs a 304 instead of the full payload.
+     * Cached entries are handed over on the calling thread, responses on the thread of the client.
+     * @param lane The lane of the scheduler to send the request in.
+     * @param url The URL of the resource.
+     * @param isWanted Abort the request once this returns false, called on the thread of the client.
+     * @param done Called with the response body or nothing if the request failed.
+     */
+    void getCached(Lane lane, const QUrl& url, Validity isWanted,
+                   std::function<void(const std::optional<CachedResponse>&)> done);
+
+    /**
+     * Revalidate a cached resource on the thread of the client without waiting for the result.
+     * @param url The URL of the resource.
+     */
+    void revalidateInBackground(const QUrl& url);
+
+    /**
+     * Create a request for a cached resource, conditional if the entry has an ETag.
+     * @param url The URL of the resource.
+     * @param entry The cached entry of the resource, if any.
+     */
+    QNetworkRequest createCacheRequest(const QUrl& url, const std::optional<HttpDiskCache::Entry>& entry) const;
+
+    /**
+     * Update the disk cache from a response.
+     * @param key The key of the cache entry.
+     * @param response The response of the resource.
+     * @param entry The entry that was revalidated, if any.
+     * @return The current body of the resource or nothing if the request failed.
+     */
+    std::optional<QByteArray> storeResponse(const QString& key, const Response& response,
+                                            const std::optional<HttpDiskCache::Entry>& entry);
+
+    QMutex devicesMutex;
+    QVector<Device> cachedDevices;
+    QDateTime devicesTimestamp;
+    std::atomic<uint> deviceFetches = 0;
+
+    enum class Reachability { Unknown, Online, Offline };
+    std::atomic<Reachability> reachability = Reachability::Unknown;
+    std::atomic<qint64> reachabilityTimestamp = 0;
+
+    std::atomic<qint64> lastWarmUp = 0;
+
+    std::atomic<quint64> cancelledRequests = 0;
+    std::atomic<quint64> completedRequests = 0;
+    std::atomic<quint64> coalescedRequests = 0;
+
+    /**
+     * Caller waiting for the response of a request.
+     */
+    struct Requester
+    {
+        Validity isWanted;
+        std::function<void(const Response&)> done;
+    };
+
+    /**
+     * GET request shared by all callers asking for the same resource while it is in flight.
+     */
+    struct Flight
+    {
+        QPointer<QNetworkReply> reply;
+        QList<Requester> requesters;
+        Lane lane = Lane::Search;
+    };
+
+    QHash<QString, std::shared_ptr<Flight>> flights;
+    QTimer cancellationTimer;
+    RequestScheduler scheduler;
+
     /**
-     * Wait for a specific signal from an object.
-     * @param sender The object emitting the signal.
-     * @param signal The signal to wait for.
+     * File waiting for a free download slot.
      */
-    static void waitForSignal(const QObject* sender, const char* signal);
+    struct Download
+    {
+        QString filePath;
+        QString url;
+        Validity isWanted;
+        std::function<void()> done;
+    };
+
+    std::atomic<int> maxParallelDownloads = 1;
+    int runningDownloads = 0;
+    QList<Download> downloadQueue;
+    QSet<QString> downloads;  // Paths of files queued or being downloaded
+
+    /**
+     * Start queued downloads while there are free download slots.
+     */
+    void startDownloads();
+
+    /**
+     * Run a function on the thread of the client, right away if it is the calling thread.
+     * @param function The function to run.
+     */
+    void runOnClientThread(const std::function<void()>& function);
+
+    /**
+     * Send a GET request, joining an identical one (same URL and authorization) in flight.
+     * The request waits in its lane of the scheduler until the rate budget allows to send it,
+     * it is dropped or aborted once none of its requesters want it anymore.
+     * Must be called on the thread of the client.
+     * @param lane The lane of the scheduler to send the request in.
+     * @param request The request to send.
+     * @param isWanted Drop this requester once this returns false, may be empty.
+     * @param done Called with the response once the request finishes.
+     */
+    void get(Lane lane, const QNetworkRequest& request, Validity isWanted,
+             std::function<void(const Response&)> done);
+
+    /**
+     * Drop requesters that lost interest and abort requests nobody wants anymore.
+     */
+    void dropUnwantedRequests();
+
+    /**
+     * Read status, headers and body of a finished reply.
+     * @param reply The finished reply.
+     */
+    static Response toResponse(QNetworkReply* reply);
+
+    /**
+     * Pause the lane of a reply the server answered with 429 Too Many Requests
+     * for as long as its Retry-After header asks.
+     * @param lane The lane the reply was sent in.
+     * @param reply The finished reply.
+     */
+    void observeRateLimit(Lane lane, QNetworkReply* reply);
+
+    /**
+     * Store a new reachability verdict along with the current time.
+     * @param state The new reachability state.
+     */
+    void setReachability(Reachability state);
+
+    /**
+     * Learn about the server reachability from the outcome of a reply and count it.
+     * @param reply The reply to observe.
+     * @return The same reply for convenience.
+     */
+    QNetworkReply* observe(QNetworkReply* reply);
+
+    /**
+     * Save content of a finished reply to a file.
+     * @param reply The finished reply.
+     * @param filePath File path to save the content to.
+     */
+    void saveReply(QNetworkReply* reply, const QString& filePath);
 
     /**
      * Convert a JSON string to a JSON object.
@@ -136,20 +603,7 @@ private:
      */
     static Device parseDevice(QJsonObject deviceData);
 
-    /**
-     * Parse a JSON object to a track object.
-     * @param trackData The JSON object to parse.
-     * @return The parsed track object.
-     */
-    static Track parseTrack(QJsonObject trackData);
-
-    /**
-     * Linearize a list of artists to a single string.
-     * @param artists The list of artists to linearize.
-     * @return String of artists separated by commas.
-     */
-    static QString linearizeArtists(const QJsonArray& artists);
-
 signals:
-    void deviceReady(const Track&, QString);
+    void accessTokenChanged(const QString& token, const QDateTime& expiration);
+    void fileDownloaded(const QString& filePath, qint64 size);
 };
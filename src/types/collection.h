@@ -0,0 +1,21 @@
+// Copyright (C) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include <QString>
+
+/**
+ * Album, artist or playlist found on Spotify.
+ * Collections are played as a whole by their context URI.
+ */
+class Collection
+{
+public:
+    enum class Type { Album, Artist, Playlist };
+
+    Type type = Type::Album;
+    QString id;
+    QString name;
+    QString creator;  // Artists of an album or owner of a playlist, empty for an artist
+    QString uri;
+    QString imageUrl;
+};
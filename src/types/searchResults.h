@@ -0,0 +1,16 @@
+// Copyright (C) 2020-2025 Ivo Šmerek
+
+#pragma once
+#include "collection.h"
+#include "track.h"
+#include <QVector>
+
+/**
+ * Results of one search request over several result types, each in the order of relevance.
+ */
+class SearchResults
+{
+public:
+    QVector<Track> tracks;
+    QVector<Collection> collections;  // Albums, artists and playlists
+};
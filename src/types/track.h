@@ -3,6 +3,11 @@
 #pragma once
 #include <QString>
 
+/**
+ * Track found on Spotify.
+ * Results share tracks as immutable records, repeated strings like album
+ * and artist names are interned by the parser and share their data.
+ */
 class Track
 {
 public: